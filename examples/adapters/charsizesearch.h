@@ -0,0 +1,67 @@
+/** @file charsizesearch.h
+ *  @brief Search for the largest character size a text fits in.
+ *
+ * Copyright 2018 Bruce Szablak
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BDS_CHARSIZESEARCH_H
+#define BDS_CHARSIZESEARCH_H
+
+namespace BDS {
+
+// Return the largest size, no more than 'upperLimit', for which 'fits'
+// returns 'true', or 1 if there is none (size 1 is never tried).  'fits'
+// must be monotone: if a size fits, every smaller size does.  The size
+// 'estimate' (e.g. predicted from glyph advances) is tried first, and taken
+// if the next size does not fit; otherwise the sizes above (or below) it
+// are binary searched.  The result is the same as a binary search of all
+// of the sizes for any estimate, but a good one takes only two calls.
+template<class FitsFn>
+unsigned int searchCharSize(unsigned int  estimate,
+                            unsigned int  upperLimit,
+                            FitsFn&&      fits)
+{
+    if (upperLimit < 3) { // nothing to search
+        return 1;                                                     // RETURN
+    }
+    auto lowerLimit = 1u;              // fits (or is the smallest)
+    auto limit      = upperLimit + 1u; // does not fit
+    auto probe      = [&](unsigned int size) {
+        if (fits(size)) {
+            lowerLimit = size;
+        }
+        else {
+            limit      = size;
+        }
+    };
+
+    if (estimate > 1 && estimate <= upperLimit) {
+        probe(estimate);
+
+        if (lowerLimit == estimate && estimate < upperLimit) {
+            probe(estimate + 1);
+        }
+    }
+
+    while (limit - lowerLimit > 1) {
+        probe((lowerLimit + limit)/2);
+    }
+    return lowerLimit;                                                // RETURN
+}
+
+} // end BDS namespace
+
+#endif
+// vim: ts=4:sw=4:et:ai
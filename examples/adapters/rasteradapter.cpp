@@ -0,0 +1,831 @@
+/** @file rasteradapter.cpp
+ *  @brief Implements Wawt::Adapter protocol for an in-memory frame buffer.
+ *
+ * Copyright 2018 Bruce Szablak
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rasteradapter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace BDS {
+
+namespace {
+
+using Pixel = RasterAdapter::Pixel;
+
+// A character size is this many font units: 7 for the glyph, and 1 for
+// the space between lines.  A glyph's advance is 6 units: 5, and 1 more
+// for the space between glyphs.
+constexpr static const double kUNITS    = 8.0;
+constexpr static const double kADVANCE  = 6.0;
+constexpr static const double kASCENT   = 7.0;
+
+// The glyph cache is discarded when it grows this large.
+constexpr static const std::size_t kMAX_GLYPHS = 4096;
+
+// The width and height of the tiles a batch is drawn in by a pool.
+constexpr static const int kTILE = 128;
+
+// The printable ASCII characters (' ' to '~'), a byte per column from the
+// left, with bit 0 the top row.
+constexpr static const uint8_t kFONT[][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, //   !
+    {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14}, // " #
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, // $ %
+    {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, // & '
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, // ( )
+    {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08}, // * +
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, // , -
+    {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02}, // . /
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, // 0 1
+    {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31}, // 2 3
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, // 4 5
+    {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03}, // 6 7
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, // 8 9
+    {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00}, // : ;
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, // < =
+    {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06}, // > ?
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, // @ A
+    {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22}, // B C
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, // D E
+    {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A}, // F G
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, // H I
+    {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41}, // J K
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, // L M
+    {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E}, // N O
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, // P Q
+    {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31}, // R S
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, // T U
+    {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F}, // V W
+    {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, // X Y
+    {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00}, // Z [
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, // \ ]
+    {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40}, // ^ _
+    {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, // ` a
+    {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20}, // b c
+    {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, // d e
+    {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E}, // f g
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, // h i
+    {0x20,0x40,0x44,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00}, // j k
+    {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, // l m
+    {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, // n o
+    {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, // p q
+    {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20}, // r s
+    {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, // t u
+    {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C}, // v w
+    {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, // x y
+    {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00}, // z {
+    {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, // | }
+    {0x08,0x04,0x08,0x10,0x08}                              // ~
+};
+
+// Drawn for characters not in the font.
+constexpr static const uint8_t kMISSING[5] = {0x7F,0x41,0x41,0x41,0x7F};
+
+inline unsigned int div255(unsigned int x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// Blend 'source' (which is opaque) over 'target' by 'alpha'.
+inline Pixel blendPixel(Pixel target, Pixel source, unsigned int alpha) {
+    auto result = Pixel(0);
+
+    for (auto shift = 0; shift < 32; shift += 8) {
+        auto s = (source >> shift) & 0xFFu;
+        auto t = (target >> shift) & 0xFFu;
+
+        result |= Pixel(div255(s * alpha + t * (255u - alpha))) << shift;
+    }
+    return result;                                                    // RETURN
+}
+
+#if defined(__SSE2__)
+
+inline __m128i div255(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Blend 'source' (two pixels widened to 16 bits a channel) over the four
+// pixels at 'target' by the alphas of the first two ('alphaLo'), and of
+// the last two ('alphaHi'), each repeated for the four channels.
+inline void blend4(Pixel *target,
+                   __m128i source,
+                   __m128i alphaLo,
+                   __m128i alphaHi) {
+    auto zero   = _mm_setzero_si128();
+    auto full   = _mm_set1_epi16(255);
+    auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target));
+    auto lo     = _mm_unpacklo_epi8(pixels, zero);
+    auto hi     = _mm_unpackhi_epi8(pixels, zero);
+
+    lo = div255(_mm_add_epi16(_mm_mullo_epi16(source, alphaLo),
+                _mm_mullo_epi16(lo, _mm_sub_epi16(full, alphaLo))));
+    hi = div255(_mm_add_epi16(_mm_mullo_epi16(source, alphaHi),
+                _mm_mullo_epi16(hi, _mm_sub_epi16(full, alphaHi))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(target),
+                     _mm_packus_epi16(lo, hi));
+}
+
+#endif
+
+// Blend 'source' (which is opaque) over the 'count' pixels at 'target' by
+// 'alpha', scaled by each pixel's 'coverage' if there is one.  Four pixels
+// at a time with SSE2; the results are the same without it.
+void blendSpan(Pixel         *target,
+               int            count,
+               Pixel          source,
+               unsigned int   alpha,
+               const uint8_t *coverage) {
+    auto i = 0;
+
+    if (!coverage && alpha == 255u) {
+#if defined(__SSE2__)
+        auto pixels = _mm_set1_epi32(int(source));
+
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), pixels);
+        }
+#endif
+        std::fill(target + i, target + count, source);
+        return;                                                       // RETURN
+    }
+#if defined(__SSE2__)
+    auto zero    = _mm_setzero_si128();
+    auto colors  = _mm_unpacklo_epi8(_mm_set1_epi32(int(source)), zero);
+    auto alphas  = _mm_set1_epi16(short(alpha));
+
+    for (; i + 4 <= count; i += 4) {
+        if (coverage) {
+            int32_t packed;
+            std::memcpy(&packed, coverage + i, sizeof packed);
+
+            auto scaled = div255(_mm_mullo_epi16(
+                            _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero),
+                            alphas));
+            auto pairs  = _mm_unpacklo_epi16(scaled, scaled);
+
+            blend4(target + i,
+                   colors,
+                   _mm_unpacklo_epi32(pairs, pairs),
+                   _mm_unpackhi_epi32(pairs, pairs));
+        }
+        else {
+            blend4(target + i, colors, alphas, alphas);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        auto scaled = coverage ? div255(coverage[i] * alpha) : alpha;
+
+        target[i] = blendPixel(target[i], source, scaled);
+    }
+    return;                                                           // RETURN
+}
+
+// The length of the overlap of [lo0, hi0) and [lo1, hi1).
+inline double overlap(double lo0, double hi0, double lo1, double hi1) {
+    return std::max(0.0, std::min(hi0, hi1) - std::max(lo0, lo1));
+}
+
+inline double textUnits(std::size_t length, bool bold) {
+    // The space after the last glyph is not part of the text, unless a bold
+    // glyph is smeared into it.
+    return length > 0 ? kADVANCE * length - (bold ? 0 : 1) : 0.0;
+}
+
+inline double textWidth(std::size_t length, double charSize, bool bold) {
+    return textUnits(length, bold) * charSize / kUNITS;
+}
+
+} // end unnamed namespace
+
+                                //--------------------
+                                // class RasterAdapter
+                                //--------------------
+
+// PRIVATE CLASS METHODS
+void
+RasterAdapter::clipTile(Tile                    *tile,
+                        const Tile&              area,
+                        const Wawt::DrawRegion  *clip)
+{
+    tile->d_x0 = area.d_x0;
+    tile->d_y0 = area.d_y0;
+    tile->d_x1 = area.d_x1;
+    tile->d_y1 = area.d_y1;
+
+    if (clip) { // the region's corners are pixels, so it is inclusive
+        auto& ul = clip->d_upperLeft;
+        auto& lr = clip->d_lowerRight;
+
+        tile->d_x0 = int(std::max(double(tile->d_x0), std::floor(ul.d_x)));
+        tile->d_y0 = int(std::max(double(tile->d_y0), std::floor(ul.d_y)));
+        tile->d_x1 = int(std::min(double(tile->d_x1), std::floor(lr.d_x)+1));
+        tile->d_y1 = int(std::min(double(tile->d_y1), std::floor(lr.d_y)+1));
+    }
+    return;                                                           // RETURN
+}
+
+// PRIVATE METHODS
+void
+RasterAdapter::bin(std::size_t                 index,
+                   const Wawt::DrawDirective&  widget,
+                   const std::wstring&         text,
+                   int                         columns)
+{
+    // Find the pixels the widget may draw on (see: 'drawOn'), allowing for
+    // rounding, bullets, borders drawn outside circles, and text that does
+    // not fit.  Its glyphs are cached now, as the tiles only read them.
+    auto x0 = std::floor(widget.d_upperLeft.d_x)  - 4;
+    auto y0 = std::floor(widget.d_upperLeft.d_y)  - 4;
+    auto x1 = std::ceil(widget.d_lowerRight.d_x)  + 4;
+    auto y1 = std::ceil(widget.d_lowerRight.d_y)  + 4;
+
+    if (widget.d_bulletType != Wawt::BulletType::eNONE) {
+        x1 = std::max(x1, std::ceil(widget.d_upperLeft.d_x
+                                                    + widget.height()) + 4);
+    }
+
+    if (!text.empty() || widget.d_cursor >= 0) {
+        auto charSize = double(widget.d_charSize);
+        auto unit     = charSize / kUNITS;
+        auto centery  = (widget.d_upperLeft.d_y + widget.d_lowerRight.d_y)/2;
+        auto glyphs   = std::max(double(text.length()),
+                                 double(widget.d_cursor) + 1);
+
+        x0 = std::min(x0, std::floor(widget.d_startx - unit) - 4);
+        x1 = std::max(x1, std::ceil(widget.d_startx + glyphs * kADVANCE * unit
+                                                    + charSize/16) + 4);
+        y0 = std::min(y0, std::floor(centery - charSize/2) - 4);
+        y1 = std::max(y1, std::ceil(centery + charSize/2) + 4);
+
+        if (widget.d_charSize > 0) {
+            auto bold = d_commands[index].d_options->d_boldEffect;
+
+            for (auto character : text) {
+                glyph(character, widget.d_charSize, bold);
+            }
+        }
+    }
+    if (auto clip = d_commands[index].d_clip) {
+        x0 = std::max(x0, std::floor(clip->d_upperLeft.d_x));
+        y0 = std::max(y0, std::floor(clip->d_upperLeft.d_y));
+        x1 = std::min(x1, std::floor(clip->d_lowerRight.d_x));
+        y1 = std::min(y1, std::floor(clip->d_lowerRight.d_y));
+    }
+    auto rows   = int(d_bins.size()) / columns;
+    auto first  = std::max(0, int(x0) / kTILE);
+    auto last   = std::min(columns - 1, int(x1) / kTILE);
+    auto top    = std::max(0, int(y0) / kTILE);
+    auto bottom = std::min(rows - 1, int(y1) / kTILE);
+
+    for (auto row = top; row <= bottom; ++row) {
+        for (auto column = first; column <= last; ++column) {
+            d_bins[row * columns + column].push_back(uint32_t(index));
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::blend(Tile                       *tile,
+                     int                         x,
+                     int                         y,
+                     int                         count,
+                     const DrawOptions::Color&   color,
+                     const uint8_t              *coverage)
+{
+    if (y < tile->d_y0 || y >= tile->d_y1 || color.d_alpha == 0) {
+        return;                                                       // RETURN
+    }
+
+    if (x < tile->d_x0) {
+        auto skip = tile->d_x0 - x;
+
+        count -= skip;
+
+        if (coverage) {
+            coverage += skip;
+        }
+        x = tile->d_x0;
+    }
+    count = std::min(count, tile->d_x1 - x);
+
+    if (count > 0) {
+        blendSpan(&d_pixels[std::size_t(y) * std::size_t(d_width) + x],
+                  count,
+                  makePixel(color) | 0xFF000000u,
+                  color.d_alpha,
+                  coverage);
+    }
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::drawBox(Tile                     *tile,
+                       double                    x,
+                       double                    y,
+                       double                    width,
+                       double                    height,
+                       const DrawOptions::Color& lineColor,
+                       const DrawOptions::Color& fillColor,
+                       double                    borderThickness)
+{
+    auto x0 = int(std::lround(x));
+    auto y0 = int(std::lround(y));
+    auto x1 = int(std::lround(x + width));
+    auto y1 = int(std::lround(y + height));
+
+    fill(tile, x0, y0, x1, y1, fillColor);
+
+    if (lineColor.d_alpha > 0 && borderThickness > 0) {
+        // The border is inside the box.
+        auto t = std::min({int(std::lround(borderThickness)),
+                           (x1 - x0 + 1)/2,
+                           (y1 - y0 + 1)/2});
+
+        fill(tile, x0,     y0,     x1,     y0 + t, lineColor);
+        fill(tile, x0,     y1 - t, x1,     y1,     lineColor);
+        fill(tile, x0,     y0 + t, x0 + t, y1 - t, lineColor);
+        fill(tile, x1 - t, y0 + t, x1,     y1 - t, lineColor);
+    }
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::drawCircle(Tile                     *tile,
+                          double                    centerx,
+                          double                    centery,
+                          double                    radius,
+                          const DrawOptions::Color& lineColor,
+                          const DrawOptions::Color& fillColor,
+                          double                    borderThickness)
+{
+    // The border is outside the radius.  A pixel is covered in proportion
+    // to how far the circle's edge is past its center.
+    auto outer = radius + (lineColor.d_alpha > 0 ? borderThickness : 0.0);
+    auto x0    = int(std::floor(centerx - outer - 1));
+    auto x1    = int(std::ceil(centerx + outer + 1));
+    auto y0    = std::max(int(std::floor(centery - outer - 1)), tile->d_y0);
+    auto y1    = std::min(int(std::ceil(centery + outer + 1)),  tile->d_y1);
+    auto edge  = [](double distance) {
+        return std::min(1.0, std::max(0.0, distance + 0.5));
+    };
+    auto& coverage = tile->d_coverage;
+
+    coverage.resize(x1 - x0);
+
+    for (auto y = y0; y < y1; ++y) {
+        auto dy = y + 0.5 - centery;
+
+        for (auto pass = 0; pass < 2; ++pass) {
+            for (auto x = x0; x < x1; ++x) {
+                auto dx       = x + 0.5 - centerx;
+                auto distance = std::sqrt(dx*dx + dy*dy);
+                auto inside   = edge(radius - distance);
+                auto covered  = pass == 0 ? inside
+                                          : edge(outer - distance) - inside;
+
+                coverage[x - x0] = uint8_t(std::lround(covered * 255));
+            }
+            blend(tile,
+                  x0,
+                  y,
+                  x1 - x0,
+                  pass == 0 ? fillColor : lineColor,
+                  coverage.data());
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::drawOn(Tile                         *tile,
+                      const Wawt::DrawDirective&    widget,
+                      const DrawOptions&            options,
+                      const std::wstring&           text)
+{
+    auto lineColor   = options.d_lineColor;
+    auto fillColor   = options.d_fillColor;
+    auto textColor   = options.d_textColor;
+    auto selectColor = options.d_selectColor;
+
+    if (widget.d_greyEffect) {
+        if (lineColor.d_alpha == 255u) {
+            lineColor.d_alpha = options.d_greyedEffect;
+        }
+
+        if (fillColor.d_alpha == 255u) {
+            fillColor.d_alpha = options.d_greyedEffect;
+        }
+
+        if (textColor.d_alpha == 255u) {
+            textColor.d_alpha = options.d_greyedEffect;
+        }
+    }
+    drawBox(tile,
+            widget.d_upperLeft.d_x,
+            widget.d_upperLeft.d_y,
+            widget.width(),
+            widget.height(),
+            lineColor,
+            (widget.d_selected && widget.d_bulletType==Wawt::BulletType::eNONE)
+                ? selectColor : fillColor,
+            widget.d_borderThickness);
+
+    if (widget.d_bulletType == Wawt::BulletType::eRADIO) {
+        auto height = widget.height();
+
+        drawCircle(tile,
+                   widget.d_upperLeft.d_x + height/2,
+                   widget.d_upperLeft.d_y + height/2,
+                   widget.interiorHeight()/5.0,
+                   textColor, // line color
+                   widget.d_selected ? textColor : fillColor,
+                   2);
+    }
+    else if (widget.d_bulletType == Wawt::BulletType::eCHECK) {
+        auto size   = widget.interiorHeight();
+        auto center = widget.d_borderThickness + size/2.0;
+        auto offset = center - 0.2*size;
+
+        drawBox(tile,
+                widget.d_upperLeft.d_x + offset,
+                widget.d_upperLeft.d_y + offset,
+                0.4*size,
+                0.4*size,
+                textColor,
+                widget.d_selected ? textColor : fillColor,
+                2);
+    }
+
+    if (!text.empty() || widget.d_cursor >= 0) {
+        drawText(tile,
+                 widget.d_startx,
+                 (widget.d_upperLeft.d_y + widget.d_lowerRight.d_y)/2.0,
+                 widget.d_charSize,
+                 options.d_boldEffect,
+                 text,
+                 widget.d_cursor,
+                 textColor);
+    }
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::drawText(Tile                     *tile,
+                        double                    x,
+                        double                    centery,
+                        unsigned int              charSize,
+                        bool                      bold,
+                        const std::wstring&       text,
+                        int                       cursor,
+                        const DrawOptions::Color& color)
+{
+    if (charSize == 0) {
+        return;                                                       // RETURN
+    }
+    auto unit    = charSize / kUNITS;
+    auto advance = kADVANCE * unit;
+    auto top     = int(std::lround(centery - kASCENT * unit / 2.0));
+
+    // Each glyph starts on a pixel, so its coverage can be cached.
+    for (auto i = 0u; i < text.length(); ++i) {
+        auto& cached = glyph(text[i], charSize, bold);
+        auto  left   = int(std::lround(x + i * advance));
+
+        for (auto row = 0; row < cached.d_height; ++row) {
+            blend(tile,
+                  left,
+                  top + row,
+                  cached.d_width,
+                  color,
+                  cached.d_coverage.data() + row * cached.d_width);
+        }
+    }
+
+    if (cursor >= 0) {
+        auto caret  = int(std::lround(x + cursor * advance - unit));
+        auto height = int(charSize);
+        auto y0     = int(std::lround(centery - height / 2.0));
+
+        fill(tile,
+             caret,
+             y0,
+             caret + std::max(1, height/16),
+             y0 + height,
+             color);
+    }
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::fill(Tile                        *tile,
+                    int                         x0,
+                    int                         y0,
+                    int                         x1,
+                    int                         y1,
+                    const DrawOptions::Color&   color)
+{
+    y0 = std::max(y0, tile->d_y0);
+    y1 = std::min(y1, tile->d_y1);
+
+    for (auto y = y0; y < y1; ++y) {
+        blend(tile, x0, y, x1 - x0, color);
+    }
+    return;                                                           // RETURN
+}
+
+const RasterAdapter::Glyph&
+RasterAdapter::glyph(wchar_t character, unsigned int charSize, bool bold)
+{
+    auto key = (uint64_t(character) & 0x1FFFFFu)
+             | (uint64_t(charSize)  << 21)
+             | (uint64_t(bold ? 1 : 0) << 53);
+    auto it  = d_glyphs.find(key);
+
+    if (it != d_glyphs.end()) {
+        return it->second;                                            // RETURN
+    }
+    auto     bitmap  = (character >= L' ' && character <= L'~')
+                                            ? kFONT[character - L' ']
+                                            : kMISSING;
+    uint8_t  columns[6] = {};
+    auto     count   = bold ? 6 : 5;
+
+    for (auto c = 0; c < 5; ++c) {
+        columns[c]   |= bitmap[c];
+
+        if (bold) { // smeared one unit to the right
+            columns[c+1] |= bitmap[c];
+        }
+    }
+    auto  unit   = charSize / kUNITS;
+    auto& result = d_glyphs[key];
+
+    result.d_width  = int(std::ceil(count * unit));
+    result.d_height = int(std::ceil(kASCENT * unit));
+    result.d_coverage.assign(std::size_t(result.d_width) * result.d_height,
+                             0);
+
+    // A pixel's coverage is the area of the font units it overlaps.
+    for (auto y = 0; y < result.d_height; ++y) {
+        for (auto row = 0; row < int(kASCENT); ++row) {
+            auto height = overlap(y, y + 1, row * unit, (row + 1) * unit);
+
+            if (height == 0.0) {
+                continue;                                         // CONTINUE
+            }
+
+            for (auto x = 0; x < result.d_width; ++x) {
+                auto covered = 0.0;
+
+                for (auto c = 0; c < count; ++c) {
+                    if (columns[c] & (1u << row)) {
+                        covered += overlap(x, x + 1, c * unit, (c + 1) * unit);
+                    }
+                }
+                auto& value = result.d_coverage[y * result.d_width + x];
+
+                value = uint8_t(std::min(255.0,
+                                         value + covered * height * 255.0));
+            }
+        }
+    }
+    return result;                                                    // RETURN
+}
+
+// PUBLIC CREATORS
+RasterAdapter::RasterAdapter(int width, int height)
+: d_width(0)
+, d_height(0)
+, d_pixels()
+, d_frame()
+, d_view()
+, d_glyphs()
+, d_commands()
+, d_bins()
+, d_pool()
+{
+    resize(width, height);
+}
+
+RasterAdapter::~RasterAdapter()
+{
+}
+
+// PUBLIC WawtAdapterImpl INTERFACE
+
+void
+RasterAdapter::drawWidget(const Wawt::DrawDirective&  widget,
+                          const DrawOptions&          options,
+                          const std::wstring&         text)
+{
+    if (d_glyphs.size() >= kMAX_GLYPHS) {
+        d_glyphs.clear();
+    }
+    drawOn(&d_view, widget, options, text);
+    return;                                                           // RETURN
+}
+
+bool
+RasterAdapter::opaqueWidget(const Wawt::DrawDirective&  widget,
+                            const DrawOptions&          options) const
+{
+    // The box is filled with one of these (see: 'drawOn').
+    auto& fill = widget.d_selected
+              && widget.d_bulletType == Wawt::BulletType::eNONE
+                        ? options.d_selectColor : options.d_fillColor;
+
+    return fill.d_alpha == 255u && !widget.d_greyEffect;              // RETURN
+}
+
+void
+RasterAdapter::textMetrics(Wawt::DrawDirective   *parameters,
+                           const DrawOptions&     options,
+                           Wawt::TextMetrics     *metrics,
+                           const std::wstring&    text,
+                           double                 upperLimit)
+{
+    assert(metrics->d_textHeight > 0);    // these are upper limits
+    assert(metrics->d_textWidth > 0);     // bullet size excluded
+
+    // A text is a line high, and as wide as its glyphs (see: 'drawText').
+    auto length   = text.length();
+    auto bold     = options.d_boldEffect;
+    auto charSize = parameters->d_charSize;
+    auto fits     = [&](unsigned int size) {
+        return size                          < metrics->d_textHeight
+            && textWidth(length, size, bold) < metrics->d_textWidth;
+    };
+
+    if (upperLimit > 0) {
+        // The measurements are proportional to the size, so solve for the
+        // largest size that fits, then correct for any rounding.
+        auto limit  = std::max(1.0, std::floor(upperLimit));
+        auto size   = std::min(limit, std::ceil(metrics->d_textHeight) - 1);
+
+        if (length > 0) {
+            size = std::min(size,
+                            std::ceil(metrics->d_textWidth * kUNITS
+                                            / textUnits(length, bold)) - 1);
+        }
+        charSize = unsigned(std::max(1.0, size));
+
+        while (charSize > 1 && !fits(charSize)) {
+            charSize -= 1;
+        }
+
+        while (charSize < limit && fits(charSize + 1)) {
+            charSize += 1;
+        }
+        parameters->d_charSize = charSize;
+    }
+    metrics->d_textWidth  = textWidth(length, charSize, bold);
+    metrics->d_textHeight = charSize;
+    return;                                                           // RETURN
+}
+
+// PUBLIC Wawt::DrawAdapter INTERFACE
+
+void
+RasterAdapter::drawBatch(const Wawt::DrawBatch& batch)
+{
+    if (d_glyphs.size() >= kMAX_GLYPHS) {
+        d_glyphs.clear();
+    }
+
+    if (!d_pool || d_pixels.empty()) {
+        for (auto i = 0u; i < batch.size(); ++i) {
+            auto& widget = *batch.d_directives[i];
+
+            clipTile(&d_view, d_frame, batch.clip(i));
+            drawOn(&d_view, widget, options(widget), *batch.d_texts[i]);
+        }
+        clipTile(&d_view, d_frame, nullptr);
+        return;                                                       // RETURN
+    }
+
+    // Each tile draws the commands that may touch it in their order, so
+    // every pixel is blended exactly as it would be by a serial draw.
+    auto columns = (d_width  + kTILE - 1) / kTILE;
+    auto rows    = (d_height + kTILE - 1) / kTILE;
+
+    d_bins.resize(std::size_t(columns) * std::size_t(rows));
+
+    for (auto& bin : d_bins) {
+        bin.clear();
+    }
+    d_commands.clear();
+
+    for (auto i = 0u; i < batch.size(); ++i) {
+        auto& widget = *batch.d_directives[i];
+
+        d_commands.push_back(Command{&widget,
+                                     &options(widget),
+                                     batch.d_texts[i],
+                                     batch.clip(i)});
+        bin(i, widget, *batch.d_texts[i], columns);
+    }
+    auto next  = std::atomic<std::size_t>(0);
+    auto tasks = std::vector<std::function<void()>>();
+
+    for (auto i = 0u; i < d_pool->size(); ++i) {
+        tasks.emplace_back([this, &next, columns]() {
+            auto area = Tile();
+            auto tile = Tile();
+
+            for (auto index = next++; index < d_bins.size(); index = next++) {
+                auto column = int(index) % columns;
+                auto row    = int(index) / columns;
+
+                area.d_x0 = column * kTILE;
+                area.d_y0 = row    * kTILE;
+                area.d_x1 = std::min(area.d_x0 + kTILE, d_width);
+                area.d_y1 = std::min(area.d_y0 + kTILE, d_height);
+
+                for (auto command : d_bins[index]) {
+                    auto& drawn = d_commands[command];
+
+                    clipTile(&tile, area, drawn.d_clip);
+                    drawOn(&tile,
+                           *drawn.d_widget,
+                           *drawn.d_options,
+                           *drawn.d_text);
+                }
+            }
+        });
+    }
+    d_pool->run(std::move(tasks));
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::setClip(const Wawt::DrawRegion *clip)
+{
+    clipTile(&d_view, d_frame, clip);
+    return;                                                           // RETURN
+}
+
+// PUBLIC MANIPULATORS
+
+void
+RasterAdapter::clear(const DrawOptions::Color& color)
+{
+    std::fill(d_pixels.begin(), d_pixels.end(), makePixel(color));
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::resize(int width, int height)
+{
+    d_width  = std::max(width, 0);
+    d_height = std::max(height, 0);
+    d_pixels.assign(std::size_t(d_width) * std::size_t(d_height),
+                    makePixel(DrawOptions::kWHITE));
+    d_frame.d_x1 = d_width;
+    d_frame.d_y1 = d_height;
+    clipTile(&d_view, d_frame, nullptr);
+    return;                                                           // RETURN
+}
+
+void
+RasterAdapter::setThreads(unsigned int threads)
+{
+    if (threads < 2) {
+        d_pool.reset();
+    }
+    else if (!d_pool || d_pool->size() != threads) {
+        d_pool.reset(); // join the old threads first
+        d_pool = std::make_unique<Wawt::ThreadPool>(threads);
+    }
+    return;                                                           // RETURN
+}
+
+} // end BDS namespace
+
+// vim: ts=4:sw=4:et:ai
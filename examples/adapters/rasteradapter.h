@@ -0,0 +1,225 @@
+/** @file rasteradapter.h
+ *  @brief Renders Wawt screens into an in-memory RGBA frame buffer.
+ *
+ * Copyright 2018 Bruce Szablak
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BDS_RASTERADAPTER_H
+#define BDS_RASTERADAPTER_H
+
+#include "drawoptions.h"
+#include "wawt.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace BDS {
+
+                                //====================
+                                // class RasterAdapter
+                                //====================
+
+// Draws without a window or graphics context (e.g. for thumbnails, or to
+// compare screens pixel by pixel).  Text is drawn in a built-in 5x7 font
+// scaled to the character size, so its metrics are the same everywhere.
+// Large frames can be drawn in tiles on several threads (see:
+// 'setThreads').
+class RasterAdapter : public WawtAdapterImpl<RasterAdapter, DrawOptions> {
+  public:
+    // PUBLIC TYPES
+    using Pixel = uint32_t; // 0xAABBGGRR, i.e. R, G, B, A in memory order
+
+    // PUBLIC CLASS METHODS
+    static Pixel makePixel(const DrawOptions::Color& color) {
+        return Pixel(color.d_red)
+            | (Pixel(color.d_green) <<  8)
+            | (Pixel(color.d_blue)  << 16)
+            | (Pixel(color.d_alpha) << 24);
+    }
+
+    // PUBLIC CREATORS
+    RasterAdapter(int width, int height);
+
+    ~RasterAdapter();
+
+    // PUBLIC WawtAdapterImpl INTERFACE
+
+    void  drawWidget(const Wawt::DrawDirective&  widget,
+                     const DrawOptions&          options,
+                     const std::wstring&         text);
+
+    std::size_t optionsKey(const DrawOptions& options) const {
+        return options.d_boldEffect ? 2 : 1; // bold glyphs are wider
+    }
+
+    bool  opaqueWidget(const Wawt::DrawDirective&  widget,
+                       const DrawOptions&          options) const;
+
+    void  textMetrics(Wawt::DrawDirective   *parameters,
+                      const DrawOptions&     options,
+                      Wawt::TextMetrics     *metrics,
+                      const std::wstring&    text,
+                      double                 upperLimit);
+
+    // PUBLIC Wawt::DrawAdapter INTERFACE
+
+    void  drawBatch(const Wawt::DrawBatch& batch)                  override;
+
+    bool  drawsBatches() const                                     override {
+        return bool(d_pool);
+    }
+
+    void  setClip(const Wawt::DrawRegion *clip)                    override;
+
+    bool  threadSafe() const                                       override {
+        return true;
+    }
+
+    // PUBLIC MANIPULATORS
+
+    // Set every pixel to 'color'.
+    void  clear(const DrawOptions::Color& color = DrawOptions::kWHITE);
+
+    // Discard the frame, and start a new one of the given size.
+    void  resize(int width, int height);
+
+    // Draw each batch in tiles on a pool of 'threads' threads ('0' or '1'
+    // draws serially, the default).  The pixels drawn are the same.
+    void  setThreads(unsigned int threads);
+
+    // PUBLIC ACCESSORS
+    int   height() const {
+        return d_height;
+    }
+
+    Pixel pixel(int x, int y) const {
+        return d_pixels[std::size_t(y) * std::size_t(d_width) + x];
+    }
+
+    // The rows of the frame, from the top.
+    const std::vector<Pixel>& pixels() const {
+        return d_pixels;
+    }
+
+    int   width() const {
+        return d_width;
+    }
+
+  private:
+    // PRIVATE TYPES
+    struct Command {        // a directive of the batch being drawn
+        const Wawt::DrawDirective  *d_widget;
+        const DrawOptions          *d_options;
+        const std::wstring         *d_text;
+        const Wawt::DrawRegion     *d_clip;
+    };
+
+    struct Tile {           // the part of the frame being drawn on
+        int                     d_x0 = 0;
+        int                     d_y0 = 0;
+        int                     d_x1 = 0;
+        int                     d_y1 = 0;
+        std::vector<uint8_t>    d_coverage;     // a row of a circle
+    };
+
+    struct Glyph {          // coverage of each pixel, 0 to 255, by rows
+        int                     d_width  = 0;
+        int                     d_height = 0;
+        std::vector<uint8_t>    d_coverage;
+    };
+
+    // PRIVATE CLASS METHODS
+
+    // Set the bounds of 'tile' to those of 'area' within 'clip' (if any).
+    static void  clipTile(Tile                    *tile,
+                          const Tile&              area,
+                          const Wawt::DrawRegion  *clip);
+
+    // PRIVATE METHODS
+    void         bin(std::size_t                 index,
+                     const Wawt::DrawDirective&  widget,
+                     const std::wstring&         text,
+                     int                         columns);
+
+    void         blend(Tile                       *tile,
+                       int                         x,
+                       int                         y,
+                       int                         count,
+                       const DrawOptions::Color&   color,
+                       const uint8_t              *coverage = nullptr);
+
+    void         drawBox(Tile                     *tile,
+                         double                    x,
+                         double                    y,
+                         double                    width,
+                         double                    height,
+                         const DrawOptions::Color& lineColor,
+                         const DrawOptions::Color& fillColor,
+                         double                    borderThickness);
+
+    void         drawCircle(Tile                     *tile,
+                            double                    centerx,
+                            double                    centery,
+                            double                    radius,
+                            const DrawOptions::Color& lineColor,
+                            const DrawOptions::Color& fillColor,
+                            double                    borderThickness);
+
+    void         drawOn(Tile                         *tile,
+                        const Wawt::DrawDirective&    widget,
+                        const DrawOptions&            options,
+                        const std::wstring&           text);
+
+    void         drawText(Tile                     *tile,
+                          double                    x,
+                          double                    centery,
+                          unsigned int              charSize,
+                          bool                      bold,
+                          const std::wstring&       text,
+                          int                       cursor,
+                          const DrawOptions::Color& color);
+
+    void         fill(Tile                        *tile,
+                      int                         x0,
+                      int                         y0,
+                      int                         x1,
+                      int                         y1,
+                      const DrawOptions::Color&   color);
+
+    // Return the coverage of 'character', computing it if it is not
+    // cached (which is only done by the calling thread).
+    const Glyph& glyph(wchar_t character, unsigned int charSize, bool bold);
+
+    // PRIVATE DATA
+    int                      d_width;
+    int                      d_height;
+    std::vector<Pixel>       d_pixels;
+    Tile                     d_frame;       // the whole frame
+    Tile                     d_view;        // ... within 'setClip'
+    std::unordered_map<uint64_t, Glyph>
+                             d_glyphs;      // by character, size, and bold
+    std::vector<Command>     d_commands;    // the batch being drawn
+    std::vector<std::vector<uint32_t>>
+                             d_bins;        // commands by tile
+    std::unique_ptr<Wawt::ThreadPool>
+                             d_pool;        // or null if drawn serially
+};
+
+} // end BDS namespace
+
+#endif
+// vim: ts=4:sw=4:et:ai
@@ -17,14 +17,16 @@
  */
 
 #include "sfmladapter.h"
+#include "charsizesearch.h"
 #include "drawoptions.h"
 
-#include <SFML/Graphics/CircleShape.hpp>
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/Graphics/Font.hpp>
-#include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
 #include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Vertex.hpp>
 #include <SFML/System/Utf.hpp>
 #include <SFML/Window/ContextSettings.hpp>
 #include <SFML/Window/Event.hpp>
@@ -32,6 +34,7 @@
 #include <SFML/Window/VideoMode.hpp>
 #include <SFML/Window/WindowStyle.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <chrono>
 #include <thread>
@@ -42,108 +45,153 @@ namespace BDS {
 
 namespace {
 
-void drawBox(sf::RenderWindow  *window,
-             float              x,
-             float              y,
-             float              width,
-             float              height,
-             sf::Color          lineColor,
-             sf::Color          fillColor,
-             int                borderThickness) {
-    sf::RectangleShape rectangle({width, height});
+// Batches are drawn once this many texts are waiting to be drawn.
+constexpr static const std::size_t kMAX_TEXTS = 64;
+
+constexpr static const float kPI = 3.14159265f;
+
+void addQuad(sf::VertexArray *shapes,
+             sf::Vector2f     ul,
+             sf::Vector2f     ur,
+             sf::Vector2f     ll,
+             sf::Vector2f     lr,
+             sf::Color        color) {
+    shapes->append(sf::Vertex(ul, color));
+    shapes->append(sf::Vertex(ur, color));
+    shapes->append(sf::Vertex(ll, color));
+    shapes->append(sf::Vertex(ur, color));
+    shapes->append(sf::Vertex(lr, color));
+    shapes->append(sf::Vertex(ll, color));
+}
 
-    if (lineColor.a > 0 && borderThickness > 0) {
-        rectangle.setOutlineColor(lineColor);
-        rectangle.setOutlineThickness(-borderThickness);
+void addRectangle(sf::VertexArray *shapes,
+                  float            x,
+                  float            y,
+                  float            width,
+                  float            height,
+                  sf::Color        color) {
+    if (color.a > 0 && width > 0 && height > 0) {
+        addQuad(shapes,
+                {x,       y},
+                {x+width, y},
+                {x,       y+height},
+                {x+width, y+height},
+                color);
     }
-    rectangle.setFillColor(fillColor);
-    rectangle.setPosition(x, y);
-    window->draw(rectangle);
 }
 
-void drawCircle(sf::RenderWindow  *window,
-                float              centerx,
-                float              centery,
-                float              radius,
-                sf::Color          lineColor,
-                sf::Color          fillColor,
-                int                borderThickness) {
-    sf::CircleShape circle(radius, 4+int(radius));
-    circle.setOrigin(radius, radius);
+// As an 'sf::RectangleShape' whose outline is inside its bounds.
+void addBox(sf::VertexArray   *shapes,
+            float              x,
+            float              y,
+            float              width,
+            float              height,
+            sf::Color          lineColor,
+            sf::Color          fillColor,
+            int                borderThickness) {
+    addRectangle(shapes, x, y, width, height, fillColor);
 
     if (lineColor.a > 0 && borderThickness > 0) {
-        circle.setOutlineThickness(borderThickness);
-        circle.setOutlineColor(lineColor);
+        auto t = std::min(float(borderThickness), std::min(width, height)/2);
+
+        addRectangle(shapes, x,         y,          width, t,    lineColor);
+        addRectangle(shapes, x,         y+height-t, width, t,    lineColor);
+        addRectangle(shapes, x,         y+t,        t, height-2*t, lineColor);
+        addRectangle(shapes, x+width-t, y+t,        t, height-2*t, lineColor);
     }
-    circle.setFillColor(fillColor);
-    circle.setPosition(centerx, centery);
-    window->draw(circle);
 }
 
-} // end unnamed namespace
+// As an 'sf::CircleShape' whose outline is outside its radius.
+void addCircle(sf::VertexArray   *shapes,
+               float              centerx,
+               float              centery,
+               float              radius,
+               sf::Color          lineColor,
+               sf::Color          fillColor,
+               int                borderThickness) {
+    auto points  = 4 + int(radius);
+    auto outline = lineColor.a > 0 && borderThickness > 0;
+    auto point   = [=](int index, float distance) {
+        auto angle = float(index) * 2.0f * kPI / float(points) - kPI / 2.0f;
+        return sf::Vector2f(centerx + distance * std::cos(angle),
+                            centery + distance * std::sin(angle));
+    };
+
+    for (auto i = 0; i < points; ++i) {
+        if (fillColor.a > 0) {
+            shapes->append(sf::Vertex({centerx, centery}, fillColor));
+            shapes->append(sf::Vertex(point(i,   radius), fillColor));
+            shapes->append(sf::Vertex(point(i+1, radius), fillColor));
+        }
 
-                                //------------------
-                                // class SfmlAdapter
-                                //------------------
+        if (outline) {
+            auto outer = radius + float(borderThickness);
 
-SfmlAdapter::SfmlAdapter(sf::RenderWindow&   window,
-                         const std::string&  path,
-                         bool                noArrow)
-: d_window(window)
-, d_font()
-{
-    d_font.loadFromFile(path.c_str());
+            addQuad(shapes,
+                    point(i,   radius),
+                    point(i+1, radius),
+                    point(i,   outer),
+                    point(i+1, outer),
+                    lineColor);
+        }
+    }
+}
 
-    if (!noArrow) {
-        Wawt::s_downArrow = L'\u25BC';
-        Wawt::s_upArrow   = L'\u25B2';
+// A view of 'clip' that draws it where 'view' would, and nothing else.
+sf::View clipView(const sf::View& view, const sf::FloatRect& clip) {
+    auto size     = view.getSize();
+    auto corner   = view.getCenter() - size/2.0f;
+    auto viewport = view.getViewport();
+    auto clipped  = sf::View(clip);
+
+    clipped.setViewport(
+        sf::FloatRect(viewport.left + viewport.width*(clip.left-corner.x)
+                                                                / size.x,
+                      viewport.top  + viewport.height*(clip.top-corner.y)
+                                                                / size.y,
+                      viewport.width  * clip.width  / size.x,
+                      viewport.height * clip.height / size.y));
+    return clipped;                                                   // RETURN
+}
+
+// Glyph tables are built at this size; text width scales almost linearly.
+constexpr static const unsigned int kREFERENCE_SIZE = 100u;
+
+bool fitText(sf::Text                *label,
+             const sf::Font&          font,
+             unsigned int             charSize,
+             const Wawt::TextMetrics& box,
+             sf::FloatRect           *fitted) {
+    label->setCharacterSize(charSize);
+    auto bounds      = label->getLocalBounds();
+    auto lineSpacing = font.getLineSpacing(charSize);
+
+    if (lineSpacing  >= box.d_textHeight
+     || bounds.width >= box.d_textWidth) {
+        return false;                                                 // RETURN
     }
+    fitted->width  = bounds.width;
+    fitted->height = lineSpacing;
+    return true;                                                      // RETURN
 }
 
-// PUBLIC Wawt::Adapter INTERFACE
+} // end unnamed namespace
+
+                                //------------------
+                                // class SfmlAdapter
+                                //------------------
 
+// PRIVATE METHODS
 void
-SfmlAdapter::draw(const Wawt::DrawDirective&  widget,
-                  const std::wstring&        text)
+SfmlAdapter::append(const Wawt::DrawDirective&   widget,
+                    const DrawOptions&           options,
+                    const Palette&               palette,
+                    const std::wstring&          text)
 {
-    DrawOptions options;
-
-    if (widget.d_options.has_value()) {
-        try {
-            options = std::any_cast<DrawOptions>(widget.d_options);
-        }
-        catch(const std::bad_any_cast& e) {
-            auto [type, wid, idx] = widget.d_tracking;
-            std::string msg = "Bad options (any_cast). Widget="
-                            + std::to_string(wid);
-            if (idx >= 0) {
-                msg += " row=" + std::to_string(idx);
-            }
-            else {
-                msg += " index=" + std::to_string(type);
-            }
-            throw Wawt::Exception(msg);                                 // THROW
-        }
-    }
-    sf::Color lineColor{options.d_lineColor.d_red,
-                        options.d_lineColor.d_green,
-                        options.d_lineColor.d_blue,
-                        options.d_lineColor.d_alpha};
-
-    sf::Color fillColor{options.d_fillColor.d_red,
-                        options.d_fillColor.d_green,
-                        options.d_fillColor.d_blue,
-                        options.d_fillColor.d_alpha};
-
-    sf::Color textColor{options.d_textColor.d_red,
-                        options.d_textColor.d_green,
-                        options.d_textColor.d_blue,
-                        options.d_textColor.d_alpha};
-
-    sf::Color selectColor{options.d_selectColor.d_red,
-                          options.d_selectColor.d_green,
-                          options.d_selectColor.d_blue,
-                          options.d_selectColor.d_alpha};
+    auto lineColor   = palette.d_lineColor;
+    auto fillColor   = palette.d_fillColor;
+    auto textColor   = palette.d_textColor;
+    auto selectColor = palette.d_selectColor;
 
     if (widget.d_greyEffect) {
         if (lineColor.a == 255u) {
@@ -158,28 +206,41 @@ SfmlAdapter::draw(const Wawt::DrawDirective&  widget,
             textColor.a = options.d_greyedEffect;
         }
     }
-    drawBox(&d_window,
-            float(widget.d_upperLeft.d_x),
-            float(widget.d_upperLeft.d_y),
-            float(widget.width()+1),
-            float(widget.height()+1),
-            lineColor,
-            (widget.d_selected && widget.d_bulletType==Wawt::BulletType::eNONE)
-                ? selectColor : fillColor,
-            widget.d_borderThickness);
+    auto bounds = sf::FloatRect(float(widget.d_upperLeft.d_x),
+                                float(widget.d_upperLeft.d_y),
+                                float(widget.width()+1),
+                                float(widget.height()+1));
+
+    // The shapes are drawn before the texts, so the texts this widget
+    // covers must be drawn first.
+    for (auto& textBounds : d_textBounds) {
+        if (textBounds.intersects(bounds)) {
+            flush();
+            break;                                                     // BREAK
+        }
+    }
+    addBox(&d_shapes,
+           bounds.left,
+           bounds.top,
+           bounds.width,
+           bounds.height,
+           lineColor,
+           (widget.d_selected && widget.d_bulletType==Wawt::BulletType::eNONE)
+               ? selectColor : fillColor,
+           widget.d_borderThickness);
 
     if (widget.d_bulletType == Wawt::BulletType::eRADIO) {
         // Bullet size:
         auto height = widget.height();
         auto radius = float(widget.interiorHeight())/5.0;
 
-        drawCircle(&d_window,
-                   float(widget.d_upperLeft.d_x + height/2),
-                   float(widget.d_upperLeft.d_y + height/2),
-                   radius,
-                   textColor, // line color
-                   widget.d_selected ? textColor : fillColor,
-                   2);
+        addCircle(&d_shapes,
+                  float(widget.d_upperLeft.d_x + height/2),
+                  float(widget.d_upperLeft.d_y + height/2),
+                  radius,
+                  textColor, // line color
+                  widget.d_selected ? textColor : fillColor,
+                  2);
     }
     else if (widget.d_bulletType == Wawt::BulletType::eCHECK) {
         auto size   = float(widget.interiorHeight());
@@ -188,53 +249,308 @@ SfmlAdapter::draw(const Wawt::DrawDirective&  widget,
         auto ul_x   = float(widget.d_upperLeft.d_x + offset);
         auto ul_y   = float(widget.d_upperLeft.d_y + offset);
 
-        drawBox(&d_window,
-                ul_x,
-                ul_y,
-                float(0.4*size),
-                float(0.4*size),
-                textColor,
-                widget.d_selected ? textColor : fillColor,
-                2);
+        addBox(&d_shapes,
+               ul_x,
+               ul_y,
+               float(0.4*size),
+               float(0.4*size),
+               textColor,
+               widget.d_selected ? textColor : fillColor,
+               2);
     }
 
-    if (!text.empty()) {
-        sf::Text  label{text, d_font, widget.d_charSize};
+    if (!text.empty() || widget.d_cursor >= 0) {
+        auto& label = retainedText(widget, text, options.d_boldEffect);
 
         label.setFillColor(textColor);
 
-        if (options.d_boldEffect) {
-            label.setStyle(sf::Text::Bold);
-        }
         auto centery = (widget.d_upperLeft.d_y + widget.d_lowerRight.d_y)/2.0f;
-        auto bounds  = label.getLocalBounds();
+        auto local   = label.getLocalBounds();
 
-        label.setOrigin(bounds.left, bounds.top + bounds.height/2.0f);
+        label.setOrigin(local.left, local.top + local.height/2.0f);
         label.setPosition(widget.d_startx, centery);
-        d_window.draw(label);
+        d_texts.push_back(&label);
+        d_textBounds.push_back(label.getGlobalBounds());
+
+        if (widget.d_cursor >= 0) {
+            auto caret  = label.findCharacterPos(widget.d_cursor);
+            auto height = float(widget.d_charSize);
+
+            auto& bar    = d_textBounds.emplace_back(caret.x,
+                                                     centery - height/2.0f,
+                                                     std::max(1.0f,
+                                                              height/16.0f),
+                                                     height);
+
+            addRectangle(&d_carets,
+                         bar.left,
+                         bar.top,
+                         bar.width,
+                         bar.height,
+                         textColor);
+        }
+
+        if (d_texts.size() >= kMAX_TEXTS) {
+            flush();
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+SfmlAdapter::flush()
+{
+    auto draw = [this](sf::RenderTarget *target) {
+        target->draw(d_shapes);
+
+        for (auto text : d_texts) {
+            target->draw(*text);
+        }
+        target->draw(d_carets);
+    };
+
+    for (auto target : { static_cast<sf::RenderTarget*>(&d_frame),
+                         static_cast<sf::RenderTarget*>(&d_window) }) {
+        if (target == &d_frame && !d_retain) {
+            continue;                                             // CONTINUE
+        }
+
+        if (d_clips.empty() && !d_panelClipped) {
+            draw(target);
+        }
+        else {
+            // Only the damaged regions are drawn (see: 'damage'), within
+            // the panel's box (see: 'setClip').
+            auto view    = target->getView();
+            auto clipped = [&](const sf::FloatRect& clip) {
+                auto visible = clip;
+
+                if (!d_panelClipped
+                 || clip.intersects(d_panelClip, visible)) {
+                    target->setView(clipView(view, visible));
+                    draw(target);
+                }
+            };
+
+            if (d_clips.empty()) {
+                clipped(d_panelClip);
+            }
+
+            for (auto& clip : d_clips) {
+                clipped(clip);
+            }
+            target->setView(view);
+        }
+    }
+    d_shapes.clear();
+    d_carets.clear();
+    d_texts.clear();
+    d_textBounds.clear();
+    return;                                                           // RETURN
+}
+
+SfmlAdapter::Palette
+SfmlAdapter::makePalette(const DrawOptions& options)
+{
+    return Palette{{options.d_lineColor.d_red,
+                    options.d_lineColor.d_green,
+                    options.d_lineColor.d_blue,
+                    options.d_lineColor.d_alpha},
+                   {options.d_fillColor.d_red,
+                    options.d_fillColor.d_green,
+                    options.d_fillColor.d_blue,
+                    options.d_fillColor.d_alpha},
+                   {options.d_textColor.d_red,
+                    options.d_textColor.d_green,
+                    options.d_textColor.d_blue,
+                    options.d_textColor.d_alpha},
+                   {options.d_selectColor.d_red,
+                    options.d_selectColor.d_green,
+                    options.d_selectColor.d_blue,
+                    options.d_selectColor.d_alpha}};                  // RETURN
+}
+
+const SfmlAdapter::Palette&
+SfmlAdapter::palette(const Wawt::DrawDirective&  widget,
+                     const DrawOptions&          options,
+                     Palette                    *converted) const
+{
+    // A style's colors were converted when the style table was set.
+    if (widget.d_style != 0) {
+        return d_palettes[widget.d_style];                            // RETURN
+    }
+    *converted = makePalette(options);
+    return *converted;                                                // RETURN
+}
+
+sf::Text&
+SfmlAdapter::retainedText(const Wawt::DrawDirective&  widget,
+                          const std::wstring&         text,
+                          bool                        bold)
+{
+    // Setting the string, size, or style rebuilds the glyphs, so only do
+    // that when the widget changed since it was last drawn.  A style's
+    // boldness is not part of the widget, so it is checked here.
+    auto  rebuild = false;
+    auto& label   = widget.cache<Label>(&rebuild);
+
+    if (rebuild || label.d_bold != bold || label.d_font != &d_font) {
+        label.d_text.setFont(d_font);
+        label.d_text.setString(text);
+        label.d_text.setCharacterSize(widget.d_charSize);
+        label.d_text.setStyle(bold ? sf::Text::Bold : sf::Text::Regular);
+        label.d_bold = bold;
+        label.d_font = &d_font;
+    }
+    return label.d_text;                                              // RETURN
+}
+
+unsigned int
+SfmlAdapter::estimateCharSize(const sf::String&          string,
+                              bool                       bold,
+                              const Wawt::TextMetrics&   box,
+                              unsigned int               upperLimit)
+{
+    auto& table = d_glyphs[bold ? 1 : 0];
+    auto  width = 0.0f;
+    auto  prior = sf::Uint32(0);
+
+    for (auto next : string) {
+        auto it = table.d_advances.find(next);
+
+        if (it == table.d_advances.end()) {
+            auto advance = d_font.getGlyph(next, kREFERENCE_SIZE, bold)
+                                 .advance;
+            it = table.d_advances.emplace(next, advance).first;
+        }
+        width += it->second;
+
+        if (prior != 0) {
+            auto pair    = (sf::Uint64(prior) << 32) | next;
+            auto kerning = table.d_kernings.find(pair);
+
+            if (kerning == table.d_kernings.end()) {
+                auto value = d_font.getKerning(prior, next, kREFERENCE_SIZE);
+                kerning = table.d_kernings.emplace(pair, value).first;
+            }
+            width += kerning->second;
+        }
+        prior = next;
+    }
+    // The largest size whose line spacing, and width, are strictly less
+    // than the box's:
+    auto scale = double(box.d_textHeight) / d_lineSpacing;
+
+    if (width > 0) {
+        scale = std::min(scale, double(box.d_textWidth) / width);
+    }
+    auto size = std::ceil(scale * kREFERENCE_SIZE) - 1;
+    return unsigned(std::clamp(size, 2.0, double(upperLimit)));      // RETURN
+}
+
+// PUBLIC CREATORS
+
+SfmlAdapter::SfmlAdapter(sf::RenderWindow&   window,
+                         const std::string&  path,
+                         bool                noArrow)
+: d_window(window)
+, d_font()
+, d_glyphs()
+, d_lineSpacing(0)
+, d_frame()
+, d_frameView()
+, d_clips()
+, d_panelClip()
+, d_panelClipped(false)
+, d_retain(true)
+, d_palettes()
+, d_shapes(sf::Triangles)
+, d_carets(sf::Triangles)
+, d_texts()
+, d_textBounds()
+{
+    d_font.loadFromFile(path.c_str());
+    d_lineSpacing = d_font.getLineSpacing(kREFERENCE_SIZE);
+
+    for (auto bold : { false, true }) {
+        auto& table = d_glyphs[bold ? 1 : 0];
+
+        for (auto c = sf::Uint32(' '); c <= sf::Uint32('~'); ++c) {
+            table.d_advances[c] = d_font.getGlyph(c, kREFERENCE_SIZE, bold)
+                                        .advance;
+        }
+    }
+
+    if (!noArrow) {
+        Wawt::s_downArrow = L'\u25BC';
+        Wawt::s_upArrow   = L'\u25B2';
+    }
+}
+
+// PUBLIC WawtAdapterImpl INTERFACE
+
+void
+SfmlAdapter::drawWidget(const Wawt::DrawDirective&  widget,
+                        const DrawOptions&          options,
+                        const std::wstring&         text)
+{
+    Palette converted;
+
+    // Only a panel that is not indexed is drawn a widget at a time (see:
+    // 'Wawt::draw'), and its frames are not preceded by a call to 'damage',
+    // so the regions of the last damaged frame no longer apply.
+    d_clips.clear();
+    append(widget, options, palette(widget, options, &converted), text);
+    flush();
+    return;                                                           // RETURN
+}
+
+void
+SfmlAdapter::prepareStyles(const std::vector<const DrawOptions*>& styles)
+{
+    d_palettes.resize(styles.size());
+
+    for (auto id = 1u; id < styles.size(); ++id) {
+        d_palettes[id] = makePalette(*styles[id]);
     }
     return;                                                           // RETURN
 }
 
+bool
+SfmlAdapter::opaqueWidget(const Wawt::DrawDirective&  widget,
+                          const DrawOptions&          options) const
+{
+    // The box is filled with one of these (see: 'append').
+    auto& fill = widget.d_selected
+              && widget.d_bulletType == Wawt::BulletType::eNONE
+                        ? options.d_selectColor : options.d_fillColor;
+
+    return fill.d_alpha == 255u && !widget.d_greyEffect;              // RETURN
+}
+
+std::size_t
+SfmlAdapter::optionsKey(const DrawOptions& effects) const
+{
+    // Only the font and the bold effect change a text's measurements.
+    return 1 + (std::size_t(effects.d_fontIndex) << 1)
+             + (effects.d_boldEffect ? 1 : 0);                        // RETURN
+}
+
 void
-SfmlAdapter::getTextMetrics(Wawt::DrawDirective   *parameters,
-                            Wawt::TextMetrics     *metrics,
-                            const std::wstring&   text,
-                            double                startLimit)
+SfmlAdapter::textMetrics(Wawt::DrawDirective   *parameters,
+                         const DrawOptions&     effects,
+                         Wawt::TextMetrics     *metrics,
+                         const std::wstring&    text,
+                         double                 startLimit)
 {
     assert(metrics->d_textHeight > 0);    // these are upper limits
     assert(metrics->d_textWidth > 0);     // bullet size excluded
 
-    DrawOptions   effects;
     sf::String    string(text);
     sf::FloatRect bounds(0,0,0,0);
     uint16_t      charSize = uint16_t(std::round(parameters->d_charSize));
     sf::Text      label{string, d_font, charSize};
 
-    if (parameters->d_options.has_value()) {
-        effects = std::any_cast<DrawOptions>(parameters->d_options);
-    }
-
     if (effects.d_boldEffect) {
         label.setStyle(sf::Text::Bold);
     }
@@ -244,30 +560,128 @@ SfmlAdapter::getTextMetrics(Wawt::DrawDirective   *parameters,
         bounds = label.getLocalBounds();
     }
     else {
-        auto lowerLimit = 1u;
-        charSize        = upperLimit;
+        // Find the largest size, no more than 'upperLimit', that fits.  The
+        // glyph tables predict it, but hinting makes scaling slightly
+        // non-linear, so the prediction is checked (see: 'searchCharSize').
+        // The sizes that fit are tried in increasing order, so 'bounds' is
+        // left with the measurements of the one found.
+        auto estimate = estimateCharSize(string,
+                                         effects.d_boldEffect,
+                                         *metrics,
+                                         upperLimit);
+
+        parameters->d_charSize
+            = searchCharSize(estimate,
+                             upperLimit,
+                             [&](unsigned int size) {
+                                 return fitText(&label,
+                                                d_font,
+                                                size,
+                                                *metrics,
+                                                &bounds);
+                             });
+    }
+    metrics->d_textWidth  = bounds.width;
+    metrics->d_textHeight = bounds.height;
+    return;                                                           // RETURN
+}
 
-        while (upperLimit - lowerLimit > 1) {
-            label.setCharacterSize(charSize);
-            auto newBounds = label.getLocalBounds();
-            auto lineSpacing = d_font.getLineSpacing(charSize);
+// PUBLIC Wawt::DrawAdapter INTERFACE
 
-            if (lineSpacing      >= metrics->d_textHeight
-             || newBounds.width  >= metrics->d_textWidth) {
-                upperLimit = charSize;
-            }
-            else {
-                lowerLimit = charSize;
+void
+SfmlAdapter::drawBatch(const Wawt::DrawBatch& batch)
+{
+    Palette converted;
+    auto    clip = static_cast<const Wawt::DrawRegion*>(nullptr);
 
-                bounds.width  = newBounds.width;
-                bounds.height = lineSpacing;
-            }
-            charSize   = (upperLimit + lowerLimit)/2;
+    for (auto i = 0u; i < batch.size(); ++i) {
+        auto& widget  = *batch.d_directives[i];
+        auto& options = this->options(widget);
+
+        if (batch.clip(i) != clip) {
+            clip = batch.clip(i);
+            setClip(clip);
         }
-        parameters->d_charSize = lowerLimit;
+        append(widget,
+               options,
+               palette(widget, options, &converted),
+               *batch.d_texts[i]);
     }
-    metrics->d_textWidth  = bounds.width;
-    metrics->d_textHeight = bounds.height;
+    setClip(nullptr); // draws the rest
+    return;                                                           // RETURN
+}
+
+bool
+SfmlAdapter::damage(const std::vector<Wawt::DrawRegion>&  regions,
+                    bool                                  wholeFrame)
+{
+    auto size    = d_window.getSize();
+    auto view    = d_window.getView();
+    auto current = d_frame.getSize()       == size
+                && d_frameView.getCenter() == view.getCenter()
+                && d_frameView.getSize()   == view.getSize();
+
+    d_clips.clear();
+
+    if (!current) {
+        d_retain    = d_frame.create(size.x, size.y);
+        d_frameView = view;
+    }
+
+    if (!d_retain) {
+        return false;                                                 // RETURN
+    }
+    d_frame.setView(view);
+
+    if (!current || wholeFrame) {
+        d_frame.clear();
+        return false;                                                 // RETURN
+    }
+    // The window was cleared: show the retained frame, then clear the
+    // damaged regions of both for the widgets to be drawn over them.
+    d_frame.display();
+    d_window.setView(sf::View(sf::FloatRect(0, 0, float(size.x),
+                                                  float(size.y))));
+    d_window.draw(sf::Sprite(d_frame.getTexture()));
+    d_window.setView(view);
+
+    auto cleared = sf::VertexArray(sf::Triangles);
+
+    for (auto& region : regions) {
+        auto& ul   = region.d_upperLeft;
+        auto& lr   = region.d_lowerRight;
+        auto& clip = d_clips.emplace_back(float(ul.d_x),
+                                          float(ul.d_y),
+                                          float(lr.d_x - ul.d_x + 1),
+                                          float(lr.d_y - ul.d_y + 1));
+
+        addRectangle(&cleared,
+                     clip.left,
+                     clip.top,
+                     clip.width,
+                     clip.height,
+                     sf::Color::Black);
+    }
+    d_frame.draw(cleared, sf::BlendNone);
+    d_window.draw(cleared, sf::BlendNone);
+    return true;                                                      // RETURN
+}
+
+void
+SfmlAdapter::setClip(const Wawt::DrawRegion *clip)
+{
+    flush(); // what was appended is clipped as it was then
+
+    if (clip) {
+        auto& ul = clip->d_upperLeft;
+        auto& lr = clip->d_lowerRight;
+
+        d_panelClip = sf::FloatRect(float(ul.d_x),
+                                    float(ul.d_y),
+                                    float(lr.d_x - ul.d_x + 1),
+                                    float(lr.d_y - ul.d_y + 1));
+    }
+    d_panelClipped = clip != nullptr;
     return;                                                           // RETURN
 }
 
@@ -280,11 +694,38 @@ SfmlWindow::eventLoop(sf::RenderWindow&                 window,
 {
     Wawt::FocusCb   onKey;
     Wawt::EventUpCb mouseUp;
+    bool            resizing = false;
 
     while (window.isOpen()) {
         sf::Event event;
+        bool      ready = resizing ? window.pollEvent(event)
+                                   : window.waitEvent(event);
+
+        if (!ready && resizing) {
+            // A drag-resize is over when a poll interval passes without
+            // any further events; let the screen complete its layout.
+            std::this_thread::sleep_for(pollInterval);
+            ready = window.pollEvent(event);
+
+            if (!ready) {
+                resizing = false;
+
+                try {
+                    if (connector.idle()) {
+                        window.clear();
+                        connector.draw();
+                        window.display();
+                    }
+                }
+                catch (Wawt::Exception& ex) {
+                    std::cerr << ex.what() << std::endl;
+                    window.close();
+                }
+                continue;                                             // CONTINUE
+            }
+        }
 
-        if (window.waitEvent(event)) {
+        if (ready) {
             try {
                 if (event.type == sf::Event::Closed) {
                     connector.shutdownRequested([&window]() {
@@ -305,6 +746,7 @@ SfmlWindow::eventLoop(sf::RenderWindow&                 window,
 
                     sf::View view(sf::FloatRect(0, 0, width, height));
                     connector.resize(width, height);
+                    resizing = true;
 
                     window.clear();
                     window.setView(view);
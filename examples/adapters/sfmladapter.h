@@ -19,17 +19,26 @@
 #ifndef BDS_SFMLADAPTER_H
 #define BDS_SFMLADAPTER_H
 
+#include <SFML/Graphics/Color.hpp>
 #include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/RenderTexture.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/View.hpp>
 
+#include "drawoptions.h"
 #include "wawt.h"
 #include "wawtconnector.h"
 
 #include <chrono>
+#include <unordered_map>
+#include <vector>
 
 namespace BDS {
 
-class SfmlAdapter : public Wawt::DrawAdapter {
+class SfmlAdapter : public WawtAdapterImpl<SfmlAdapter, DrawOptions> {
   public:
 
     // PUBLIC CREATORS
@@ -37,19 +46,102 @@ class SfmlAdapter : public Wawt::DrawAdapter {
                 const std::string&  fontPath,
                 bool                noArrow);
 
+    // PUBLIC WawtAdapterImpl INTERFACE
+
+    void  drawWidget(const Wawt::DrawDirective&  widget,
+                     const DrawOptions&          options,
+                     const std::wstring&         text);
+
+    std::size_t optionsKey(const DrawOptions& options) const;
+
+    void  prepareStyles(const std::vector<const DrawOptions*>& styles);
+
+    bool  opaqueWidget(const Wawt::DrawDirective&  widget,
+                       const DrawOptions&          options) const;
+
+    void  textMetrics(Wawt::DrawDirective   *parameters,
+                      const DrawOptions&     options,
+                      Wawt::TextMetrics     *metrics,
+                      const std::wstring&    text,
+                      double                 upperLimit);
+
     // PUBLIC Wawt::DrawAdapter INTERFACE
 
-    void  draw(const Wawt::DrawDirective&  widget,
-               const std::wstring&         text)                   override;
+    bool  drawsBatches() const                                     override {
+        return true;
+    }
+
+    void  drawBatch(const Wawt::DrawBatch& batch)                  override;
+
+    bool  retainsFrame() const                                     override {
+        return d_retain;
+    }
+
+    bool  damage(const std::vector<Wawt::DrawRegion>&  regions,
+                 bool                                  wholeFrame) override;
 
-    void  getTextMetrics(Wawt::DrawDirective   *parameters,
-                         Wawt::TextMetrics     *metrics,
-                         const std::wstring&    text,
-                         double                 upperLimit = 0)    override;
+    void  setClip(const Wawt::DrawRegion *clip)                    override;
 
   private:
+    // PRIVATE TYPES
+    struct GlyphTable {     // measured at the reference character size
+        std::unordered_map<sf::Uint32, float>   d_advances;
+        std::unordered_map<sf::Uint64, float>   d_kernings;
+    };
+
+    struct Palette {        // the colors of a 'DrawOptions'
+        sf::Color               d_lineColor;
+        sf::Color               d_fillColor;
+        sf::Color               d_textColor;
+        sf::Color               d_selectColor;
+    };
+
+    struct Label {          // cached in a widget's 'Wawt::DrawDirective'
+        sf::Text                d_text;
+        bool                    d_bold     = false;
+        const sf::Font         *d_font     = nullptr; // adapter's font
+    };
+
+    // PRIVATE CLASS METHODS
+    static Palette makePalette(const DrawOptions& options);
+
+    // PRIVATE METHODS
+    void         append(const Wawt::DrawDirective&   widget,
+                        const DrawOptions&           options,
+                        const Palette&               palette,
+                        const std::wstring&          text);
+
+    void         flush();
+
+    const Palette& palette(const Wawt::DrawDirective&  widget,
+                           const DrawOptions&          options,
+                           Palette                    *converted) const;
+
+    sf::Text&    retainedText(const Wawt::DrawDirective&  widget,
+                              const std::wstring&         text,
+                              bool                        bold);
+
+    unsigned int estimateCharSize(const sf::String&          string,
+                                  bool                       bold,
+                                  const Wawt::TextMetrics&   box,
+                                  unsigned int               upperLimit);
+
+    // PRIVATE DATA
     sf::RenderWindow&        d_window;
     sf::Font                 d_font;
+    GlyphTable               d_glyphs[2];   // regular, and bold
+    float                    d_lineSpacing; // at the reference size
+    sf::RenderTexture        d_frame;       // copy of the last frame
+    sf::View                 d_frameView;   // window's view of 'd_frame'
+    std::vector<sf::FloatRect> d_clips;     // this frame's damage, if any
+    sf::FloatRect            d_panelClip;   // see: 'setClip'
+    bool                     d_panelClipped;
+    bool                     d_retain;      // 'd_frame' could be created
+    std::vector<Palette>     d_palettes;    // by style ID
+    sf::VertexArray          d_shapes;      // boxes & bullets not drawn
+    sf::VertexArray          d_carets;      // drawn over 'd_texts'
+    std::vector<const sf::Text*>  d_texts;  // texts not drawn
+    std::vector<sf::FloatRect>    d_textBounds; // ... and their bounds
 };
 
 struct SfmlWindow {
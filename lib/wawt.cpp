@@ -18,25 +18,37 @@
 
 #include "wawt.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace BDS {
 
 namespace {
 
-constexpr static const std::size_t kCANVAS    = 0;
-constexpr static const std::size_t kTEXTENTRY = 1;
-constexpr static const std::size_t kLABEL     = 2;
-constexpr static const std::size_t kBUTTON    = 3;
-constexpr static const std::size_t kBUTTONBAR = 4;
-constexpr static const std::size_t kLIST      = 5;
-constexpr static const std::size_t kPANEL     = 6;
+constexpr static const std::size_t kCANVAS     = 0;
+constexpr static const std::size_t kTEXTENTRY  = 1;
+constexpr static const std::size_t kLABEL      = 2;
+constexpr static const std::size_t kBUTTON     = 3;
+constexpr static const std::size_t kBUTTONBAR  = 4;
+constexpr static const std::size_t kLIST       = 5;
+constexpr static const std::size_t kPANEL      = 6;
+constexpr static const std::size_t kTEXTEDITOR = 7;
 
 constexpr static const Wawt::Vertex kUPPER_LEFT   {-1.0_M,-1.0_M};
 constexpr static const Wawt::Vertex kUPPER_CENTER { 0.0_M,-1.0_M};
@@ -48,6 +60,12 @@ constexpr static const Wawt::Vertex kCENTER_LEFT  {-1.0_M, 0.0_M};
 constexpr static const Wawt::Vertex kCENTER_CENTER{ 0.0_M, 0.0_M};
 constexpr static const Wawt::Vertex kCENTER_RIGHT { 1.0_M, 0.0_M};
 
+// Beyond this many separate damaged regions they are drawn as one.
+constexpr static const std::size_t kMAX_DAMAGE = 16;
+
+// The opaque boxes kept when looking for widgets they cover.
+constexpr static const std::size_t kMAX_OCCLUDERS = 8;
+
 const char * const s_alignment[] = { "LEFT", "CENTER", "RIGHT" };
 
 using FontIdMap  = std::map<Wawt::FontSizeGrp, uint16_t>;
@@ -110,9 +128,9 @@ bool findBox(const Wawt::DrawDirective **box,
     return false;                                                     // RETURN
 }
 
-const Wawt::DrawDirective *getAdapterView(const Wawt::Panel& parent,
-                                          const Wawt::Panel& root,
-                                          Wawt::WidgetId     id) {
+const Wawt::DrawDirective *findAdapterView(const Wawt::Panel& parent,
+                                           const Wawt::Panel& root,
+                                           Wawt::WidgetId     id) {
     const Wawt::DrawDirective *view = nullptr;
 
     if (id.isSet()) {
@@ -137,9 +155,16 @@ const Wawt::DrawDirective *getAdapterView(const Wawt::Panel& parent,
             }
         }
         else {
-            findBox(&view, root, id);
+            view = root.findView(id);
         }
     }
+    return view;                                                      // RETURN
+}
+
+const Wawt::DrawDirective *getAdapterView(const Wawt::Panel& parent,
+                                          const Wawt::Panel& root,
+                                          Wawt::WidgetId     id) {
+    auto view = findAdapterView(parent, root, id);
 
     if (!view) {
         throw Wawt::Exception("Context of widget not found.", id);      // THROW
@@ -152,46 +177,107 @@ bool handleChar(Wawt::Base            *base,
                 uint16_t              maxChars,
                 wchar_t               pressed)
 {
-    auto text = base->textView().getText();
-    bool hasCursor = !text.empty() && text.back() == Wawt::s_cursor;
-
-    if (hasCursor) {
-        text.pop_back();
-        base->drawView().selected() = false;
-    }
+    // The text is edited in place at the caret, which is passed to the
+    // adapter in 'DrawDirective::d_cursor' rather than added to the text.
+    auto& block     = base->textView();
+    auto& view      = base->drawView();
+    auto  length    = block.getText().length();
+    bool  hasCursor = view.cursor() >= 0;
+    auto  cursor    = hasCursor ? std::min(std::size_t(view.cursor()), length)
+                                : length;
 
     if (pressed) {
         if (pressed == L'\b') {
-            if (!text.empty()) {
-                text.pop_back();
+            if (cursor > 0) {
+                block.eraseText(--cursor);
             }
         }
         else if (pressed == L'\r') {
-            bool ret = (*enterFn) ? (*enterFn)(&text) : true;
-            base->textView().setText(text);
+            auto text = block.getText();
+            bool ret  = (*enterFn) ? (*enterFn)(&text) : true;
+            block.setText(std::move(text));
+            view.cursor()   = -1;
+            view.selected() = false;
             return ret;                                               // RETURN
         }
-        else if (text.length() < maxChars) {
-            text.push_back(pressed);
+        else if (length < maxChars) {
+            block.insertText(cursor++, pressed);
         }
-        text.push_back(Wawt::s_cursor);
-        base->drawView().selected() = true;
+        view.cursor()   = int(cursor);
+        view.selected() = true;
     }
-    else if (!hasCursor) {
-        text.push_back(Wawt::s_cursor);
-        base->drawView().selected() = true;
+    else if (hasCursor) {
+        view.cursor()   = -1;
+        view.selected() = false;
+    }
+    else {
+        view.cursor()   = int(length);
+        view.selected() = true;
     }
-    base->textView().setText(text);
     return false;                                                     // RETURN
 }
 
-Wawt::DrawPosition makeAbsolute(const Wawt::Position& position,
-                               const Wawt::Panel&    parent,
-                               const Wawt::Panel&    root) {
-    auto        view       = getAdapterView(parent, root, position.d_widgetId);
-    auto&       upperLeft  = view->d_upperLeft;
-    auto&       lowerRight = view->d_lowerRight;
-    auto        thickness  = view->d_borderThickness;
+bool hasFontSizeGroup(const Wawt::Panel::Widget& widget)
+{
+    auto grouped = [](const Wawt::Base& base) {
+        return base.textView().fontSizeGrp().has_value();
+    };
+
+    if (widget.index() == kBUTTONBAR) {
+        auto& buttons = std::get<Wawt::ButtonBar>(widget).d_buttons;
+        return std::any_of(buttons.begin(), buttons.end(), grouped);  // RETURN
+    }
+
+    if (widget.index() == kLIST) {
+        auto& rows = std::get<Wawt::List>(widget).rows();
+        return std::any_of(rows.begin(), rows.end(), grouped);        // RETURN
+    }
+    return widget.index() != kPANEL && std::visit(grouped, widget);   // RETURN
+}
+
+int layoutDependency(const Wawt::Panel&  parent,
+                     const Wawt::Panel&  root,
+                     Wawt::WidgetId      id,
+                     std::size_t         slots) {
+    // Return the index slot of the widget referenced by 'id' in a layout
+    // position ('0' for the root panel), or '-1' if it does not resolve.
+    // This mirrors the resolution performed by 'getAdapterView'.
+    if (!id.isSet()) {
+        return -1;                                                    // RETURN
+    }
+
+    if (id.isRelative()) {
+        if (id.value() == UINT16_MAX) { // see: kPARENT
+            auto slot = parent.d_widgetId.value();
+            return &parent == &root ? 0 : int(slot);                  // RETURN
+        }
+
+        if (id.value() == UINT16_MAX-1) { // see: kROOT
+            return 0;                                                 // RETURN
+        }
+        uint16_t offset = id.value();
+
+        for (auto const& nextWidget : parent.widgets()) {
+            if (--offset == 0) {
+                return std::visit([](const Wawt::Base& r) {
+                                     return int(r.d_widgetId.value());
+                                  }, nextWidget);                     // RETURN
+            }
+        }
+        return -1;                                                    // RETURN
+    }
+
+    if (id == root.d_widgetId) {
+        return 0;                                                     // RETURN
+    }
+    return id.value() < slots ? int(id.value()) : -1;                 // RETURN
+}
+
+Wawt::DrawPosition makeAbsolute(const Wawt::Position&       position,
+                                const Wawt::DrawDirective&  view) {
+    auto&       upperLeft  = view.d_upperLeft;
+    auto&       lowerRight = view.d_lowerRight;
+    auto        thickness  = view.d_borderThickness;
 
     auto xorigin = (upperLeft.d_x  + lowerRight.d_x)/2.0;
     auto yorigin = (upperLeft.d_y  + lowerRight.d_y)/2.0;
@@ -235,10 +321,18 @@ Wawt::DrawPosition makeAbsolute(const Wawt::Position& position,
     return Wawt::DrawPosition{x,y};                                 // RETURN
 }
 
+Wawt::DrawPosition makeAbsolute(const Wawt::Position& position,
+                               const Wawt::Panel&    parent,
+                               const Wawt::Panel&    root) {
+    return makeAbsolute(position,
+                        *getAdapterView(parent, root, position.d_widgetId));
+}
+
 void refreshTextMetric(Wawt::DrawDirective            *args,
                        Wawt::TextBlock                *block,
                        Wawt::DrawAdapter              *adapter_p,
-                       FontIdMap&                     fontIdToSize) {
+                       FontIdMap&                     fontIdToSize,
+                       Wawt::TextMetricsCache        *cache) {
     auto  id         = block->fontSizeGrp();
     auto  textHeight = args->interiorHeight();
     auto  fontSize   = id.has_value() ? fontIdToSize.find(*id)->second : 0;
@@ -248,7 +342,7 @@ void refreshTextMetric(Wawt::DrawDirective            *args,
                                       : 0;
 
     if (charSize != args->d_charSize) {
-        block->initTextMetricValues(args, adapter_p, charSize);
+        block->initTextMetricValues(args, adapter_p, charSize, cache);
 
         if (fontSize == 0 && id.has_value()) {
             fontIdToSize[*id] = args->d_charSize;
@@ -286,21 +380,53 @@ double scaleBorder(double borderScale, double thickness) {
     return scaled;
 }
 
-Wawt::FocusCb scroll(Wawt::Panel *root, Wawt::WidgetId id, unsigned int delta)
-{
-    auto& panel = root->lookup<Wawt::Panel>(id,    "Scroll panel");
-    auto& up    = panel.lookup<Wawt::Button>(1_wr, "Scroll up button");
-    auto& down  = panel.lookup<Wawt::Button>(2_wr, "Scroll down button");
-    auto& list  = panel.lookup<Wawt::List>(3_wr,   "Scroll list");
-    list.setStartingRow(list.startRow() + delta, &up, &down);
-    return Wawt::FocusCb();                                            // RETURN
+void scaleBorders(const double   *thickness,
+                  double         *scaled,
+                  std::size_t     count,
+                  double          borderScale) {
+    // Batch form of 'scaleBorder': 'int(scaled) == 0' holds exactly when
+    // -1 < scaled < 1.
+    std::size_t i = 0;
+#if defined(__AVX__)
+    auto vscale = _mm256_set1_pd(borderScale);
+    auto one    = _mm256_set1_pd(1.0);
+    auto minus  = _mm256_set1_pd(-1.0);
+    auto zero   = _mm256_setzero_pd();
+
+    for (; i + 4 <= count; i += 4) {
+        auto t    = _mm256_loadu_pd(thickness + i);
+        auto v    = _mm256_mul_pd(vscale, t);
+        auto mask = _mm256_and_pd(
+                        _mm256_and_pd(_mm256_cmp_pd(v, one,   _CMP_LT_OQ),
+                                      _mm256_cmp_pd(v, minus, _CMP_GT_OQ)),
+                        _mm256_cmp_pd(t, zero, _CMP_GT_OQ));
+        _mm256_storeu_pd(scaled + i, _mm256_blendv_pd(v, one, mask));
+    }
+#endif
+#if defined(__SSE2__)
+    auto vscale2 = _mm_set1_pd(borderScale);
+    auto one2    = _mm_set1_pd(1.0);
+    auto minus2  = _mm_set1_pd(-1.0);
+    auto zero2   = _mm_setzero_pd();
+
+    for (; i + 2 <= count; i += 2) {
+        auto t    = _mm_loadu_pd(thickness + i);
+        auto v    = _mm_mul_pd(vscale2, t);
+        auto mask = _mm_and_pd(_mm_and_pd(_mm_cmplt_pd(v, one2),
+                                          _mm_cmpgt_pd(v, minus2)),
+                               _mm_cmpgt_pd(t, zero2));
+        _mm_storeu_pd(scaled + i, _mm_or_pd(_mm_and_pd(mask, one2),
+                                            _mm_andnot_pd(mask, v)));
+    }
+#endif
+    for (; i < count; ++i) {
+        scaled[i] = scaleBorder(borderScale, thickness[i]);
+    }
 }
 
-void setAdapterValues(Wawt::DrawDirective      *args,
-                      Wawt::Layout             *layout,
-                      const Wawt::Panel&        parent,
-                      const Wawt::Panel&        root,
-                      const Wawt::Scale&        scale) {
+void scaleLayout(Wawt::DrawDirective      *args,
+                 Wawt::Layout             *layout,
+                 const Wawt::Scale&        scale) {
     auto borderScale = std::min(scale.first, scale.second);
 
     args->d_borderThickness
@@ -311,43 +437,97 @@ void setAdapterValues(Wawt::DrawDirective      *args,
     layout->d_upperLeft.d_y  *= scale.second;
     layout->d_lowerRight.d_x *= scale.first;
     layout->d_lowerRight.d_y *= scale.second;
+}
 
-    args->d_upperLeft  = makeAbsolute(layout->d_upperLeft,  parent, root);
-    args->d_lowerRight = makeAbsolute(layout->d_lowerRight, parent, root);
+void scaleSpans(double       *upper,
+                double       *lower,
+                std::size_t   count,
+                double        scale) {
+    // Batch form of 'scaleAdapterParameters' for one axis.  The operations
+    // (and their order) are the same so the results are bit-identical.
+    std::size_t i = 0;
+#if defined(__AVX__)
+    auto vscale = _mm256_set1_pd(scale);
+    auto one    = _mm256_set1_pd(1.0);
+
+    for (; i + 4 <= count; i += 4) {
+        auto u      = _mm256_loadu_pd(upper + i);
+        auto l      = _mm256_loadu_pd(lower + i);
+        auto extent = _mm256_add_pd(_mm256_sub_pd(l, u), one);
+        u           = _mm256_mul_pd(u, vscale);
+        l           = _mm256_sub_pd(
+                          _mm256_add_pd(u, _mm256_mul_pd(extent, vscale)),
+                          one);
+        _mm256_storeu_pd(upper + i, u);
+        _mm256_storeu_pd(lower + i, l);
+    }
+#endif
+#if defined(__SSE2__)
+    auto vscale2 = _mm_set1_pd(scale);
+    auto one2    = _mm_set1_pd(1.0);
+
+    for (; i + 2 <= count; i += 2) {
+        auto u      = _mm_loadu_pd(upper + i);
+        auto l      = _mm_loadu_pd(lower + i);
+        auto extent = _mm_add_pd(_mm_sub_pd(l, u), one2);
+        u           = _mm_mul_pd(u, vscale2);
+        l           = _mm_sub_pd(_mm_add_pd(u, _mm_mul_pd(extent, vscale2)),
+                                 one2);
+        _mm_storeu_pd(upper + i, u);
+        _mm_storeu_pd(lower + i, l);
+    }
+#endif
+    for (; i < count; ++i) {
+        auto extent = lower[i] - upper[i] + 1;
+        upper[i]   *= scale;
+        lower[i]    = upper[i] + extent * scale - 1;
+    }
+}
+
+Wawt::FocusCb scroll(Wawt::Panel *root, Wawt::WidgetId id, unsigned int delta)
+{
+    auto& panel = root->lookup<Wawt::Panel>(id,    "Scroll panel");
+    auto& up    = panel.lookup<Wawt::Button>(1_wr, "Scroll up button");
+    auto& down  = panel.lookup<Wawt::Button>(2_wr, "Scroll down button");
+    auto& list  = panel.lookup<Wawt::List>(3_wr,   "Scroll list");
+    list.setStartingRow(list.startRow() + delta, &up, &down);
+    return Wawt::FocusCb();                                            // RETURN
+}
 
+void tieCorners(Wawt::DrawDirective *args, Wawt::TieScale tie) {
     // "tie" is used to create a square widgets.
-    if (layout->d_tie == Wawt::TieScale::eUL_X) {
+    if (tie == Wawt::TieScale::eUL_X) {
         auto ux     = args->d_upperLeft.d_x;
         auto uy     = args->d_upperLeft.d_y;
         auto offset = args->d_lowerRight.d_y - uy;
         args->d_lowerRight.d_x = ux + offset;
     }
-    else if (layout->d_tie == Wawt::TieScale::eUL_Y) {
+    else if (tie == Wawt::TieScale::eUL_Y) {
         auto ux     = args->d_upperLeft.d_x;
         auto uy     = args->d_upperLeft.d_y;
         auto offset = args->d_lowerRight.d_x - ux;
         args->d_lowerRight.d_y = uy + offset;
     }
-    else if (layout->d_tie == Wawt::TieScale::eLR_X) {
+    else if (tie == Wawt::TieScale::eLR_X) {
         auto lx     = args->d_lowerRight.d_x;
         auto ly     = args->d_lowerRight.d_y;
         auto offset = args->d_upperLeft.d_y - ly;
         args->d_upperLeft.d_x = lx + offset;
     }
-    else if (layout->d_tie == Wawt::TieScale::eLR_Y) {
+    else if (tie == Wawt::TieScale::eLR_Y) {
         auto lx     = args->d_lowerRight.d_x;
         auto ly     = args->d_lowerRight.d_y;
         auto offset = args->d_upperLeft.d_x - lx;
         args->d_upperLeft.d_y = ly + offset;
     }
-    else if (layout->d_tie == Wawt::TieScale::eCC_X) {
+    else if (tie == Wawt::TieScale::eCC_X) {
         auto h      = args->height();
         auto w      = args->width();
         auto offset = (h - w)/2.0;
         args->d_upperLeft.d_x  -= offset;
         args->d_lowerRight.d_x += offset;
     }
-    else if (layout->d_tie == Wawt::TieScale::eCC_Y) {
+    else if (tie == Wawt::TieScale::eCC_Y) {
         auto h      = args->height();
         auto w      = args->width();
         auto offset = (w - h)/2.0;
@@ -356,6 +536,178 @@ void setAdapterValues(Wawt::DrawDirective      *args,
     }
 }
 
+void setAdapterValues(Wawt::DrawDirective      *args,
+                      Wawt::Layout             *layout,
+                      const Wawt::Panel&        parent,
+                      const Wawt::Panel&        root,
+                      const Wawt::Scale&        scale) {
+    scaleLayout(args, layout, scale);
+
+    args->d_upperLeft  = makeAbsolute(layout->d_upperLeft,  parent, root);
+    args->d_lowerRight = makeAbsolute(layout->d_lowerRight, parent, root);
+
+    tieCorners(args, layout->d_tie);
+}
+
+// Return 'true' if 'view' is not as it was last drawn.  Only scalars are
+// compared: 'textGeneration' changes whenever the text does, and the content
+// of the options is changed by assignment (see: 'Wawt::DrawOptions').
+inline bool drawnDiffers(const Wawt::DrawDirective& view,
+                         std::size_t                textGeneration) {
+    auto& drawn = view.d_cache.d_drawn;
+
+    return drawn.d_text            != textGeneration
+        || drawn.d_upperLeft.d_x   != view.d_upperLeft.d_x
+        || drawn.d_upperLeft.d_y   != view.d_upperLeft.d_y
+        || drawn.d_lowerRight.d_x  != view.d_lowerRight.d_x
+        || drawn.d_lowerRight.d_y  != view.d_lowerRight.d_y
+        || drawn.d_borderThickness != view.d_borderThickness
+        || drawn.d_startx          != view.d_startx
+        || drawn.d_charSize        != view.d_charSize
+        || drawn.d_cursor          != view.d_cursor
+        || drawn.d_style           != view.d_style
+        || drawn.d_bulletType      != view.d_bulletType
+        || drawn.d_greyEffect      != view.d_greyEffect
+        || drawn.d_selected        != view.d_selected
+        || drawn.d_hasOptions      != view.d_options.has_value();
+}
+
+// Bump the generation of 'view' if what it draws changed since it was last
+// drawn (see: 'Wawt::DrawDirective::cache').
+inline void trackGeneration(const Wawt::DrawDirective& view,
+                            std::size_t                textGeneration) {
+    auto& drawn = view.d_cache.d_drawn;
+
+    if (drawnDiffers(view, textGeneration)) {
+        drawn.d_text               = textGeneration;
+        drawn.d_upperLeft          = view.d_upperLeft;
+        drawn.d_lowerRight         = view.d_lowerRight;
+        drawn.d_borderThickness    = view.d_borderThickness;
+        drawn.d_startx             = view.d_startx;
+        drawn.d_charSize           = view.d_charSize;
+        drawn.d_cursor             = view.d_cursor;
+        drawn.d_style              = view.d_style;
+        drawn.d_bulletType         = view.d_bulletType;
+        drawn.d_greyEffect         = view.d_greyEffect;
+        drawn.d_selected           = view.d_selected;
+        drawn.d_hasOptions         = view.d_options.has_value();
+        view.d_cache.d_generation += 1;
+    }
+}
+
+// The pixels a directive may draw on, with a margin for anti-aliasing.
+Wawt::DrawRegion regionOf(const Wawt::DrawDirective& view) {
+    return Wawt::DrawRegion{{std::floor(view.d_upperLeft.d_x)  - 1,
+                             std::floor(view.d_upperLeft.d_y)  - 1},
+                            {std::ceil(view.d_lowerRight.d_x)  + 1,
+                             std::ceil(view.d_lowerRight.d_y)  + 1}};
+}
+
+inline bool sameRegion(const Wawt::DrawRegion& a, const Wawt::DrawRegion& b) {
+    return a.d_upperLeft.d_x  == b.d_upperLeft.d_x
+        && a.d_upperLeft.d_y  == b.d_upperLeft.d_y
+        && a.d_lowerRight.d_x == b.d_lowerRight.d_x
+        && a.d_lowerRight.d_y == b.d_lowerRight.d_y;
+}
+
+inline bool overlaps(const Wawt::DrawRegion& a, const Wawt::DrawRegion& b) {
+    return a.d_upperLeft.d_x  <= b.d_lowerRight.d_x
+        && b.d_upperLeft.d_x  <= a.d_lowerRight.d_x
+        && a.d_upperLeft.d_y  <= b.d_lowerRight.d_y
+        && b.d_upperLeft.d_y  <= a.d_lowerRight.d_y;
+}
+
+inline bool contains(const Wawt::DrawRegion& a, const Wawt::DrawRegion& b) {
+    return a.d_upperLeft.d_x  <= b.d_upperLeft.d_x
+        && a.d_upperLeft.d_y  <= b.d_upperLeft.d_y
+        && b.d_lowerRight.d_x <= a.d_lowerRight.d_x
+        && b.d_lowerRight.d_y <= a.d_lowerRight.d_y;
+}
+
+// Records the directives drawn in a 'Wawt::DrawBatch'.
+class BatchRecorder : public Wawt::DrawAdapter {
+    Wawt::DrawBatch *d_batch_p;
+    uint32_t         d_clip;    // of the directives drawn next
+
+  public:
+    explicit BatchRecorder(Wawt::DrawBatch *batch)
+        : d_batch_p(batch), d_clip(0) { }
+
+    void draw(const Wawt::DrawDirective&  parameters,
+              const std::wstring&         text) override {
+        d_batch_p->d_directives.push_back(&parameters);
+        d_batch_p->d_texts.push_back(&text);
+        d_batch_p->d_clips.push_back(d_clip);
+    }
+
+    void setClip(const Wawt::DrawRegion *clip) override {
+        auto& regions = d_batch_p->d_regions;
+
+        if (!clip) {
+            d_clip = 0;
+        }
+        else if (regions.empty()
+              || !contains(regions.back(), *clip)
+              || !contains(*clip, regions.back())) {
+            regions.push_back(*clip);
+            d_clip = uint32_t(regions.size());
+        }
+        else {
+            d_clip = uint32_t(regions.size()); // the same region
+        }
+    }
+
+    void getTextMetrics(Wawt::DrawDirective*,
+                        Wawt::TextMetrics*,
+                        const std::wstring&,
+                        double) override {
+        assert(!"text is not measured while drawing");
+    }
+};
+
+inline double area(const Wawt::DrawRegion& a) {
+    return (a.d_lowerRight.d_x - a.d_upperLeft.d_x)
+         * (a.d_lowerRight.d_y - a.d_upperLeft.d_y);
+}
+
+inline void intersect(Wawt::DrawRegion *a, const Wawt::DrawRegion& b) {
+    a->d_upperLeft.d_x  = std::max(a->d_upperLeft.d_x,  b.d_upperLeft.d_x);
+    a->d_upperLeft.d_y  = std::max(a->d_upperLeft.d_y,  b.d_upperLeft.d_y);
+    a->d_lowerRight.d_x = std::min(a->d_lowerRight.d_x, b.d_lowerRight.d_x);
+    a->d_lowerRight.d_y = std::min(a->d_lowerRight.d_y, b.d_lowerRight.d_y);
+}
+
+inline void unite(Wawt::DrawRegion *a, const Wawt::DrawRegion& b) {
+    a->d_upperLeft.d_x  = std::min(a->d_upperLeft.d_x,  b.d_upperLeft.d_x);
+    a->d_upperLeft.d_y  = std::min(a->d_upperLeft.d_y,  b.d_upperLeft.d_y);
+    a->d_lowerRight.d_x = std::max(a->d_lowerRight.d_x, b.d_lowerRight.d_x);
+    a->d_lowerRight.d_y = std::max(a->d_lowerRight.d_y, b.d_lowerRight.d_y);
+}
+
+// Draw the 'rows' of a 'ButtonBar' or 'List' drawn as 'owner', clipped to
+// its box and to the enclosing panel's 'clip' (if any), so rows scrolled
+// out of the box are neither drawn nor painted over it.  The adapter is
+// clipped to 'clip' again after.
+void drawRows(Wawt::DrawAdapter                *adapter,
+              const Wawt::DrawRegion           *clip,
+              const Wawt::DrawDirective&        owner,
+              const std::vector<Wawt::Button>&  rows) {
+    auto box = regionOf(owner);
+
+    if (clip) {
+        intersect(&box, *clip);
+    }
+    adapter->setClip(&box);
+
+    for (auto& row : rows) {
+        if (overlaps(box, regionOf(row.adapterView()))) {
+            row.draw(adapter);
+        }
+    }
+    adapter->setClip(clip);
+    return;                                                           // RETURN
+}
+
 } // end unnamed namespace
 
                             //-----------------
@@ -391,6 +743,7 @@ Wawt::Base::setEnablement(Enablement newSetting)
         } break;
         default: abort();
     };
+    d_link.markChanged();
     return;                                                           // RETURN
 }
 
@@ -404,12 +757,10 @@ Wawt::Base::setEnablement(Enablement newSetting)
                             //----------------------
 
 void
-Wawt::ButtonBar::draw(DrawAdapter *adapter) const
+Wawt::ButtonBar::draw(DrawAdapter *adapter, const DrawRegion *clip) const
 {
     if (Base::draw(adapter)) {
-        for (auto& btn : d_buttons) {
-            btn.draw(adapter);
-        }
+        drawRows(adapter, clip, d_draw, d_buttons);
     }
 }
 
@@ -454,12 +805,17 @@ Wawt::ButtonBar::downEvent(int x, int y)
                             //---------------------------
 
 bool
-Wawt::DrawOptions::draw(DrawAdapter *adapter, const std::wstring& text) const
+Wawt::DrawOptions::draw(DrawAdapter         *adapter,
+                        const std::wstring&  text,
+                        std::size_t          textGeneration) const
 {
     if (!d_hidden) {
 
-        if (d_options.has_value() || !text.empty()) {
-            adapter->draw(*static_cast<const DrawDirective*>(this), text);
+        if (d_options.has_value() || d_style != 0 || !text.empty()) {
+            auto& view = *static_cast<const DrawDirective*>(this);
+
+            trackGeneration(view, textGeneration);
+            adapter->draw(view, text);
         }
 
         if (d_paintFn) {
@@ -473,6 +829,212 @@ Wawt::DrawOptions::draw(DrawAdapter *adapter, const std::wstring& text) const
     return false;
 }
 
+                            //------------------------
+                            // class  Wawt::FlatScreen
+                            //------------------------
+
+void
+Wawt::FlatScreen::clear()
+{
+    d_root       = nullptr;
+    d_generation = 0;
+    d_positions  = 0;
+    d_widgets.clear();
+    d_kinds.clear();
+    d_flags.clear();
+    d_parents.clear();
+    d_ends.clear();
+    d_ux.clear();
+    d_uy.clear();
+    d_lx.clear();
+    d_ly.clear();
+    d_borders.clear();
+    d_scaled.clear();
+    d_reachable.clear();
+    return;                                                           // RETURN
+}
+
+                            //---------------------------
+                            // class  Wawt::LayoutSnapshot
+                            //---------------------------
+
+void
+Wawt::LayoutSnapshot::clear()
+{
+    d_root       = nullptr;
+    d_generation = 0;
+    d_positions  = 0;
+    d_layoutSize = DrawPosition();
+    d_entries.clear();
+    d_lists.clear();
+    d_fontIdToSize.clear();
+    return;                                                           // RETURN
+}
+
+std::size_t
+Wawt::LayoutSnapshot::bytes() const
+{
+    // Map nodes are charged their payload plus three pointers and a color.
+    auto bytes = d_entries.capacity()   * sizeof(Entry)
+               + d_lists.capacity()     * sizeof(Rows)
+               + d_fontIdToSize.size()  * (sizeof(FontSizeGrp)
+                                            + sizeof(uint16_t)
+                                            + 4*sizeof(void*));
+
+    for (auto& entry : d_entries) {
+        bytes += entry.d_text.d_string.capacity() * sizeof(wchar_t);
+    }
+    return bytes;                                                     // RETURN
+}
+
+                            //-----------------------------
+                            // class  Wawt::TextMetricsCache
+                            //-----------------------------
+
+// PRIVATE CLASS METHODS
+std::size_t
+Wawt::TextMetricsCache::hash(const Key& key)
+{
+    auto value = std::hash<std::wstring>()(key.d_text);
+    auto mix   = [&value](std::size_t next) {
+        value ^= next + 0x9e3779b97f4a7c15ull + (value << 6) + (value >> 2);
+    };
+    mix(key.d_style);
+    mix(key.d_charSize);
+    mix(std::hash<double>()(key.d_upperLimit));
+    mix(std::hash<double>()(key.d_box.d_textWidth));
+    mix(std::hash<double>()(key.d_box.d_textHeight));
+    return value;                                                     // RETURN
+}
+
+// PRIVATE METHODS
+void
+Wawt::TextMetricsCache::trim()
+{
+    while (d_lru.size() > d_capacity) {
+        auto range = d_index.equal_range(hash(d_lru.back().d_key));
+        auto last  = std::prev(d_lru.end());
+
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                d_index.erase(it);
+                break;                                                 // BREAK
+            }
+        }
+        d_lru.pop_back();
+    }
+    return;                                                           // RETURN
+}
+
+// PUBLIC METHODS
+void
+Wawt::TextMetricsCache::clear()
+{
+    std::lock_guard<std::mutex> guard(d_lock);
+    d_lru.clear();
+    d_index.clear();
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextMetricsCache::measure(DrawAdapter           *adapter,
+                                DrawDirective         *args,
+                                TextMetrics           *metrics,
+                                const std::wstring&    text,
+                                double                 upperLimit)
+{
+    auto style = adapter->styleKey(*args);
+
+    if (style == 0 || capacity() == 0) {
+        adapter->getTextMetrics(args, metrics, text, upperLimit);
+        return;                                                       // RETURN
+    }
+    // The character size is an input only when there is no size limit.
+    auto size = upperLimit > 0 ? 0u : args->d_charSize;
+    auto key  = Key{style, size, upperLimit, *metrics, text};
+    auto code = hash(key);
+    {
+        std::lock_guard<std::mutex> guard(d_lock);
+        auto range = d_index.equal_range(code);
+
+        for (auto it = range.first; it != range.second; ++it) {
+            auto entry = it->second;
+
+            if (entry->d_key == key) {
+                d_lru.splice(d_lru.begin(), d_lru, entry);
+                args->d_charSize = entry->d_charSize;
+                *metrics         = entry->d_metrics;
+                d_hits          += 1;
+                return;                                               // RETURN
+            }
+        }
+        d_misses += 1;
+    }
+    // Measure without holding the lock (see: 'DrawAdapter::threadSafe').
+    adapter->getTextMetrics(args, metrics, text, upperLimit);
+
+    std::lock_guard<std::mutex> guard(d_lock);
+    auto range = d_index.equal_range(code);
+
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->d_key == key) {
+            return; // measured concurrently                          // RETURN
+        }
+    }
+    d_lru.push_front({std::move(key), args->d_charSize, *metrics});
+    d_index.emplace(code, d_lru.begin());
+
+    trim();
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextMetricsCache::resetCounters()
+{
+    std::lock_guard<std::mutex> guard(d_lock);
+    d_hits   = 0;
+    d_misses = 0;
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextMetricsCache::setCapacity(std::size_t capacity)
+{
+    std::lock_guard<std::mutex> guard(d_lock);
+    d_capacity = capacity;
+
+    trim();
+    return;                                                           // RETURN
+}
+
+std::size_t
+Wawt::TextMetricsCache::capacity() const
+{
+    std::lock_guard<std::mutex> guard(d_lock);
+    return d_capacity;                                                // RETURN
+}
+
+std::size_t
+Wawt::TextMetricsCache::hits() const
+{
+    std::lock_guard<std::mutex> guard(d_lock);
+    return d_hits;                                                    // RETURN
+}
+
+std::size_t
+Wawt::TextMetricsCache::misses() const
+{
+    std::lock_guard<std::mutex> guard(d_lock);
+    return d_misses;                                                  // RETURN
+}
+
+std::size_t
+Wawt::TextMetricsCache::size() const
+{
+    std::lock_guard<std::mutex> guard(d_lock);
+    return d_lru.size();                                              // RETURN
+}
+
                             //-------------------------
                             // class  Wawt::InputHandler
                             //-------------------------
@@ -518,6 +1080,7 @@ Wawt::InputHandler::callSelectFn(Text            *text,
                         : (d_type == ActionType::eTOGGLE ? !previous : true);
 
     text->d_draw.d_selected = true;
+    text->d_link.markDamaged();
 
     if (callOnDown && cb) {
         cb(text);
@@ -525,6 +1088,8 @@ Wawt::InputHandler::callSelectFn(Text            *text,
 
     return  [this, cb, text, previous, finalvalue](int xup, int yup, bool up) {
                 if (up) {
+                    text->d_link.markDamaged();
+
                     if (textcontains(xup, yup, text)) {
                         text->d_draw.d_selected = finalvalue;
                         return cb ? cb(text) : Wawt::FocusCb();
@@ -544,6 +1109,7 @@ Wawt::InputHandler::callSelectFn(Base *base, const SelectFn& cb, bool callOnDown
                         : (d_type == ActionType::eTOGGLE ? !previous : true);
 
     base->d_draw.d_selected = true;
+    base->d_link.markDamaged();
 
     if (callOnDown && cb) {
         cb(nullptr);
@@ -551,6 +1117,8 @@ Wawt::InputHandler::callSelectFn(Base *base, const SelectFn& cb, bool callOnDown
 
     return  [this, cb, base, previous, finalvalue](int xup, int yup, bool up) {
                 if (up) {
+                    base->d_link.markDamaged();
+
                     if (contains(xup, yup, base)) {
                         base->d_draw.d_selected = finalvalue;
                         return cb ? cb(nullptr) : Wawt::FocusCb();
@@ -688,14 +1256,38 @@ Wawt::InputHandler::downEvent(int x, int y, Base* base)
                             // class  Wawt::Label
                             //------------------
 
+                            //-----------------------
+                            // class  Wawt::StyleTable
+                            //-----------------------
+
+Wawt::StyleId
+Wawt::StyleTable::add(std::any options)
+{
+    if (d_styles.size() > std::numeric_limits<StyleId>::max()) {
+        throw Wawt::Exception("The style table is full.");              // THROW
+    }
+    d_styles.push_back(std::move(options));
+    return StyleId(d_styles.size() - 1);                              // RETURN
+}
+
                             //----------------------
                             // class  Wawt::TextBlock
                             //----------------------
 
+void
+Wawt::TextBlock::eraseText(std::size_t position, std::size_t count)
+{
+    d_block.d_string.erase(position, count);
+    d_block.d_id  = kNOID;
+    d_generation += 1;
+    d_link.markChanged();
+}
+
 void
 Wawt::TextBlock::initTextMetricValues(Wawt::DrawDirective      *args,
                                      Wawt::DrawAdapter        *adapter,
-                                     uint16_t                 upperLimit)
+                                     uint16_t                 upperLimit,
+                                     Wawt::TextMetricsCache   *cache)
 {
     int  width  = args->interiorWidth();
     int  height = args->interiorHeight();
@@ -709,20 +1301,42 @@ Wawt::TextBlock::initTextMetricValues(Wawt::DrawDirective      *args,
     auto charSizeLimit
         = (upperLimit > 0 && upperLimit < height) ? upperLimit+1 : height;
 
-    adapter->getTextMetrics(args,
-                            &d_metrics,
-                            d_block.d_string,
-                            charSizeLimit);
+    if (cache) {
+        cache->measure(adapter,
+                       args,
+                       &d_metrics,
+                       d_block.d_string,
+                       charSizeLimit);
+    }
+    else {
+        adapter->getTextMetrics(args,
+                                &d_metrics,
+                                d_block.d_string,
+                                charSizeLimit);
+    }
     return;                                                           // RETURN
 }
+
+void
+Wawt::TextBlock::insertText(std::size_t position, wchar_t character)
+{
+    d_block.d_string.insert(position, 1, character);
+    d_block.d_id  = kNOID;
+    d_generation += 1;
+    d_link.markChanged();
+}
+
 void
 Wawt::TextBlock::setText(TextId id)
 {
     d_block.d_id = id;
+    d_mapped     = 0;
 
     if (id != kNOID) {
         d_block.d_string.clear();
     }
+    d_generation += 1;
+    d_link.markChanged();
 }
 
 void
@@ -730,37 +1344,538 @@ Wawt::TextBlock::setText(std::wstring string)
 {
     d_block.d_string = std::move(string);
     d_block.d_id     = kNOID;
+    d_generation    += 1;
+    d_link.markChanged();
 }
 
 void
 Wawt::TextBlock::setText(const TextMapper& mappingFn)
 {
     if (d_block.d_id != kNOID && mappingFn) {
-        d_block.d_string = mappingFn(d_block.d_id);
+        auto string = mappingFn(d_block.d_id);
+
+        if (string != d_block.d_string) {
+            d_block.d_string = std::move(string);
+            d_generation    += 1;
+            d_link.markChanged();
+        }
+    }
+}
+
+void
+Wawt::TextBlock::setText(TextTable *table)
+{
+    if (d_block.d_id != kNOID && d_mapped != table->generation()) {
+        auto string = table->lookup(d_block.d_id);
+
+        if (string) {
+            if (*string != d_block.d_string) {
+                d_block.d_string = *string;
+                d_generation    += 1;
+                d_link.markChanged();
+            }
+            d_mapped = table->generation();
+        }
     }
 }
 
                             //----------------------
-                            // class  Wawt::TextEntry
+                            // class  Wawt::TextTable
                             //----------------------
 
+const std::wstring *
+Wawt::TextTable::lookup(TextId id)
+{
+    if (!d_mapper) {
+        return nullptr;                                               // RETURN
+    }
+
+    if (id >= d_mapped.size()) {
+        d_mapped.resize(id + 1u);
+        d_strings.resize(id + 1u);
+    }
 
-                            //-----------------
-                            // class  Wawt::List
-                            //-----------------
+    if (!d_mapped[id]) {
+        d_strings[id] = d_mapper(id);
+        d_mapped[id]  = true;
+    }
+    return &d_strings[id];                                            // RETURN
+}
 
 void
-Wawt::List::draw(DrawAdapter *adapter) const
+Wawt::TextTable::setMapper(const TextMapper& mapper)
 {
-    if (Base::draw(adapter)) {
-        for (auto& btn : d_buttons) {
-            btn.draw(adapter);
+    d_mapper = mapper;
+    d_generation += 1;
+
+    for (auto id = 0u; id < d_mapped.size(); ++id) {
+        if (d_mapped[id]) {
+            if (d_mapper) {
+                d_strings[id] = d_mapper(TextId(id));
+            }
+            else {
+                d_strings[id].clear();
+                d_mapped[id] = false;
+            }
         }
     }
+    return;                                                           // RETURN
 }
 
-Wawt::List::List(Layout&&                          layout,
-                FontSizeGrp                       fontSizeGrp,
+                            //---------------------
+                            // class  Wawt::TreeLink
+                            //---------------------
+
+void
+Wawt::TreeLink::markChanged()
+{
+    auto link = d_widget ? &d_widget->d_link : nullptr;
+
+    markDamaged();
+
+    // Stop at the root (no parent), or at an already marked ancestor:
+    while (link && link->d_parent && !link->d_marked) {
+        link->d_marked = true;
+        link->d_parent->d_link.d_changes.push_back(link->d_widget);
+        link = &link->d_parent->d_link;
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TreeLink::markDamaged()
+{
+    auto link = d_widget ? &d_widget->d_link : nullptr;
+    auto root = link;
+
+    while (root && root->d_parent) {
+        root = &root->d_parent->d_link;
+    }
+
+    // Only the root's link names a widget without naming its panel:
+    if (root && root->d_widget) {
+        auto panel = static_cast<Panel*>(root->d_widget);
+
+        panel->d_index.markDamaged(link == root
+                                        ? 0
+                                        : link->d_widget->d_widgetId.value());
+    }
+    return;                                                           // RETURN
+}
+
+                            //-----------------------
+                            // class  Wawt::TextEditor
+                            //-----------------------
+
+// PRIVATE METHODS
+bool
+Wawt::TextEditor::handleChar(wchar_t pressed)
+{
+    if (pressed == L'\0') { // toggle the caret, as for a 'TextEntry'
+        d_draw.d_selected = !d_draw.d_selected;
+        d_link.markDamaged();
+    }
+    else if (pressed == L'\b') {
+        if (d_cursor > 0) {
+            erase(d_cursor - 1, 1);
+        }
+    }
+    else if (pressed == L'\r' || pressed == L'\n') {
+        insert(d_cursor, std::wstring(1, L'\n'));
+    }
+    else if (pressed == L'\t' || pressed >= L' ') {
+        insert(d_cursor, std::wstring(1, pressed));
+    }
+    scrollToCursor();
+    return false;                                                     // RETURN
+}
+
+void
+Wawt::TextEditor::refreshVisible(std::size_t firstLine, std::size_t lastLine)
+{
+    auto count = std::min(std::size_t(d_rows), lines() - d_topLine);
+
+    d_visible.resize(count);
+    d_visibleGenerations.resize(count);
+    firstLine = std::max(firstLine, d_topLine);
+    lastLine  = std::min(lastLine,  d_topLine + count - 1);
+
+    for (auto index = firstLine; index <= lastLine; ++index) {
+        d_visible[index - d_topLine]            = line(index);
+        d_visibleGenerations[index - d_topLine] = ++d_visibleChanges;
+    }
+    d_link.markDamaged();
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextEditor::scrollToCursor()
+{
+    auto caretLine = lineOf(d_cursor);
+
+    if (caretLine < d_topLine) {
+        setTopLine(caretLine);
+    }
+    else if (caretLine >= d_topLine + d_rows) {
+        setTopLine(caretLine - d_rows + 1);
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextEditor::draw(DrawAdapter *adapter) const
+{
+    if (Base::draw(adapter)) {
+        auto caretLine = lineOf(d_cursor);
+
+        // The views are kept as an adapter may batch them (see:
+        // 'DrawAdapter::drawBatch'), and each keeps its own adapter cache.
+        // The editor's options are only copied to them after its view
+        // changed (e.g. its options were replaced).
+        auto generation = adapterView().generation();
+        auto copy       = d_rowViews.size()  != d_visible.size()
+                       || d_rowGeneration    != generation;
+
+        d_rowViews.resize(d_visible.size());
+        d_rowGeneration = generation;
+
+        for (auto row = 0u; row < d_visible.size(); ++row) {
+            DrawDirective& view = d_rowViews[row];
+
+            rowView(&view, row);
+
+            if (copy) {
+                view.d_options             = d_draw.d_options;
+                view.d_cache.d_generation += 1;
+            }
+
+            if (d_draw.d_selected && d_topLine + row == caretLine) {
+                view.d_cursor = int(d_cursor - d_lineStarts[caretLine]);
+            }
+            trackGeneration(view, d_visibleGenerations[row]);
+            adapter->draw(view, d_visible[row]);
+        }
+    }
+    return;                                                           // RETURN
+}
+
+Wawt::TextEditor::Location
+Wawt::TextEditor::locate(std::size_t offset) const
+{
+    // An offset on a piece boundary is located at the start of the
+    // following piece (or just past the last one).
+    auto piece = std::size_t(0);
+
+    while (piece < d_pieces.size() && offset >= d_pieces[piece].d_length) {
+        offset -= d_pieces[piece].d_length;
+        piece  += 1;
+    }
+    return Location(piece, offset);                                   // RETURN
+}
+
+void
+Wawt::TextEditor::rowView(DrawDirective *view, unsigned int row) const
+{
+    // All but the options and the adapter's cache (see: 'draw').
+    auto& editor = adapterView();
+    auto  border = editor.d_borderThickness;
+    auto  height = double(editor.interiorHeight())/d_rows;
+
+    view->d_tracking          = editor.d_tracking;
+    view->d_upperLeft.d_x     = editor.d_upperLeft.d_x  + border;
+    view->d_upperLeft.d_y     = editor.d_upperLeft.d_y  + border + row*height;
+    view->d_lowerRight.d_x    = editor.d_lowerRight.d_x - border;
+    view->d_lowerRight.d_y    = view->d_upperLeft.d_y   + height - 1;
+    view->d_borderThickness   = 0.0;
+    view->d_bulletType        = editor.d_bulletType;
+    view->d_greyEffect        = editor.d_greyEffect;
+    view->d_selected          = editor.d_selected;
+    view->d_startx            = view->d_upperLeft.d_x + 1;
+    view->d_charSize          = editor.d_charSize;
+    view->d_cursor            = editor.d_cursor;
+    view->d_style             = editor.d_style;
+    std::get<2>(view->d_tracking) = int(row);
+    return;                                                           // RETURN
+}
+
+// PUBLIC CONSTRUCTORS
+Wawt::TextEditor::TextEditor(Layout&&       layout,
+                             unsigned int   rows,
+                             std::wstring   document,
+                             DrawOptions&&  options)
+: Base(std::move(layout),
+       InputHandler().defaultAction(ActionType::eENTRY),
+       TextString(),
+       std::move(options))
+, d_rows(rows > 0 ? rows : 1)
+{
+    setDocument(std::move(document));
+}
+
+// PUBLIC METHODS
+Wawt::EventUpCb
+Wawt::TextEditor::downEvent(int x, int y)
+{
+    if (d_input.disabled() || !d_input.contains(x, y, this)) {
+        return EventUpCb();                                           // RETURN
+    }
+    return  [this](int xup, int yup, bool up) {
+                if (up && d_input.contains(xup, yup, this)) {
+                    // Place the caret at the end of the line clicked on.
+                    auto top    = d_draw.d_upperLeft.d_y
+                                                + d_draw.d_borderThickness;
+                    auto height = double(d_draw.interiorHeight())/d_rows;
+                    auto row    = std::max(0.0, (yup - top)/height);
+                    auto index  = d_topLine + std::size_t(row);
+
+                    setCursor(index + 1 < lines() ? d_lineStarts[index+1] - 1
+                                                  : d_length);
+                    return FocusCb([this](wchar_t c) {
+                                       return handleChar(c);
+                                   });
+                }
+                return FocusCb();
+            };                                                        // RETURN
+}
+
+void
+Wawt::TextEditor::erase(std::size_t offset, std::size_t count)
+{
+    if (offset > d_length) {
+        throw Exception("Text editor offset is out of range.",
+                        d_widgetId);                                  // THROW
+    }
+    count = std::min(count, d_length - offset);
+
+    if (count == 0) {
+        return;                                                       // RETURN
+    }
+    auto [piece, within] = locate(offset);
+
+    if (within > 0) { // keep the head of the piece
+        auto& head = d_pieces[piece];
+        Piece tail{head.d_added, head.d_start+within, head.d_length-within};
+        head.d_length = within;
+        d_pieces.insert(d_pieces.begin() + piece + 1, tail);
+        piece += 1;
+    }
+    auto last      = piece;
+    auto remaining = count;
+
+    while (remaining > 0) {
+        auto& next = d_pieces[last];
+
+        if (next.d_length <= remaining) {
+            remaining -= next.d_length;
+            last      += 1;
+        }
+        else {
+            next.d_start  += remaining;
+            next.d_length -= remaining;
+            remaining      = 0;
+        }
+    }
+    d_pieces.erase(d_pieces.begin() + piece, d_pieces.begin() + last);
+
+    // Lines that started within the erased text are joined to the line
+    // holding 'offset'; those after it move back.
+    auto line   = lineOf(offset);
+    auto first  = d_lineStarts.begin() + line + 1;
+    auto past   = std::upper_bound(first, d_lineStarts.end(), offset + count);
+    auto joined = past != first;
+
+    for (auto it = d_lineStarts.erase(first, past);
+              it != d_lineStarts.end();
+              ++it) {
+        *it -= count;
+    }
+    d_length -= count;
+
+    if (d_cursor > offset) {
+        d_cursor = d_cursor >= offset + count ? d_cursor - count : offset;
+    }
+
+    if (d_topLine >= lines()) {
+        d_topLine = lines() - 1;
+        joined    = true;
+    }
+    refreshVisible(line, joined ? lines() : line);
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextEditor::insert(std::size_t offset, const std::wstring& text)
+{
+    if (offset > d_length) {
+        throw Exception("Text editor offset is out of range.",
+                        d_widgetId);                                  // THROW
+    }
+
+    if (text.empty()) {
+        return;                                                       // RETURN
+    }
+    auto [piece, within] = locate(offset);
+    auto start           = d_added.length();
+    auto count           = text.length();
+    auto line            = lineOf(offset);
+
+    d_added.append(text);
+
+    if (within == 0
+     && piece  >  0
+     && d_pieces[piece-1].d_added
+     && d_pieces[piece-1].d_start + d_pieces[piece-1].d_length == start) {
+        d_pieces[piece-1].d_length += count; // typing extends the last piece
+    }
+    else {
+        if (within > 0) { // split the piece around the insertion
+            auto& head = d_pieces[piece];
+            Piece tail{head.d_added,
+                       head.d_start  + within,
+                       head.d_length - within};
+            head.d_length = within;
+            d_pieces.insert(d_pieces.begin() + piece + 1, tail);
+            piece += 1;
+        }
+        d_pieces.insert(d_pieces.begin() + piece, Piece{true, start, count});
+    }
+
+    // Lines after the one holding 'offset' move forward, and each new line
+    // break starts a line.
+    auto next = d_lineStarts.begin() + line + 1;
+
+    for (auto it = next; it != d_lineStarts.end(); ++it) {
+        *it += count;
+    }
+    std::vector<std::size_t> starts;
+
+    for (auto i = 0u; i < count; ++i) {
+        if (text[i] == L'\n') {
+            starts.push_back(offset + i + 1);
+        }
+    }
+    d_lineStarts.insert(next, starts.begin(), starts.end());
+    d_length += count;
+
+    if (d_cursor >= offset) {
+        d_cursor += count;
+    }
+    refreshVisible(line, starts.empty() ? line : lines());
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextEditor::setCursor(std::size_t offset)
+{
+    d_cursor = std::min(offset, d_length);
+    d_link.markDamaged();
+    scrollToCursor();
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextEditor::setDocument(std::wstring document)
+{
+    d_original = std::move(document);
+    d_added.clear();
+    d_pieces.clear();
+    d_lineStarts.assign(1, 0);
+    d_length  = d_original.length();
+    d_cursor  = 0;
+    d_topLine = 0;
+
+    if (d_length > 0) {
+        d_pieces.push_back(Piece{false, 0, d_length});
+    }
+
+    for (auto i = 0u; i < d_length; ++i) {
+        if (d_original[i] == L'\n') {
+            d_lineStarts.push_back(i + 1);
+        }
+    }
+    refreshVisible(0, lines());
+    return;                                                           // RETURN
+}
+
+void
+Wawt::TextEditor::setTopLine(std::size_t line)
+{
+    d_topLine = std::min(line, lines() - 1);
+    refreshVisible(0, lines());
+    return;                                                           // RETURN
+}
+
+// PUBLIC ACCESSORS
+std::wstring
+Wawt::TextEditor::document() const
+{
+    std::wstring text;
+    text.reserve(d_length);
+
+    for (auto& piece : d_pieces) {
+        text.append(piece.d_added ? d_added : d_original,
+                    piece.d_start,
+                    piece.d_length);
+    }
+    return text;                                                      // RETURN
+}
+
+std::wstring
+Wawt::TextEditor::line(std::size_t index) const
+{
+    std::wstring text;
+
+    if (index < lines()) {
+        auto offset    = d_lineStarts[index];
+        auto end       = index + 1 < lines() ? d_lineStarts[index+1] - 1
+                                             : d_length;
+        auto remaining = end - offset;
+        auto [piece, within] = locate(offset);
+
+        text.reserve(remaining);
+
+        while (remaining > 0) {
+            auto& next  = d_pieces[piece++];
+            auto  count = std::min(remaining, next.d_length - within);
+
+            text.append(next.d_added ? d_added : d_original,
+                        next.d_start + within,
+                        count);
+            remaining -= count;
+            within     = 0;
+        }
+    }
+    return text;                                                      // RETURN
+}
+
+std::size_t
+Wawt::TextEditor::lineOf(std::size_t offset) const
+{
+    auto next = std::upper_bound(d_lineStarts.begin(),
+                                 d_lineStarts.end(),
+                                 offset);
+    return std::size_t(next - d_lineStarts.begin()) - 1;              // RETURN
+}
+
+                            //----------------------
+                            // class  Wawt::TextEntry
+                            //----------------------
+
+
+                            //-----------------
+                            // class  Wawt::List
+                            //-----------------
+
+void
+Wawt::List::draw(DrawAdapter *adapter, const DrawRegion *clip) const
+{
+    if (Base::draw(adapter)) {
+        drawRows(adapter, clip, d_draw, d_buttons);
+    }
+}
+
+Wawt::List::List(Layout&&                          layout,
+                FontSizeGrp                       fontSizeGrp,
                 DrawOptions&&                  options,
                 ListType                          listType,
                 Labels                            labels,
@@ -908,6 +2023,9 @@ Wawt::List::operator=(const List& rhs)
 Wawt::Button&
 Wawt::List::row(unsigned int index)
 {
+    auto buttons = d_buttons.data();
+    auto added   = index >= d_buttons.size();
+
     d_buttons.reserve(index);
 
     while (index >= d_buttons.size()) {
@@ -935,6 +2053,17 @@ Wawt::List::row(unsigned int index)
             }
         }
     }
+
+    if (buttons != d_buttons.data()) { // copies lose their links
+        for (auto& button : d_buttons) {
+            button.d_link.d_widget        = this;
+            button.d_text.d_link.d_widget = this;
+        }
+    }
+
+    if (added) { // so the new rows' text metrics are refreshed
+        d_link.markChanged();
+    }
     setButtonPositions();
     return d_buttons[index];                                          // RETURN
 }
@@ -990,18 +2119,22 @@ Wawt::List::popUpDropDown()
     canvas.d_draw.d_lowerRight = d_root->d_draw.d_lowerRight;
     canvas.d_draw.d_tracking   = std::make_tuple(kCANVAS, nextId.value(), -1);
     canvas.d_widgetId          = Wawt_Id::inc(nextId);
-    widgets.emplace_back(canvas);
-
-    auto& dropDown   = std::get<List>(widgets.emplace_back(*this));
-    auto  dropDownId = nextId.value();
+    auto& canvasWidget         = widgets.emplace_back(canvas);
+    d_root->d_index.insert(std::get<Canvas>(canvasWidget).d_widgetId,
+                           &canvasWidget,
+                           &std::get<Canvas>(canvasWidget).adapterView());
+
+    auto& dropDownWidget = widgets.emplace_back(*this);
+    auto& dropDown       = std::get<List>(dropDownWidget);
+    auto  dropDownId     = nextId.value();
     dropDown.d_draw.d_tracking    = std::make_tuple(kLIST, dropDownId, -1);
     dropDown.d_widgetId           = Wawt_Id::inc(nextId);
+    d_root->d_index.insert(dropDown.d_widgetId,
+                           &dropDownWidget,
+                           &dropDown.adapterView());
     dropDown.d_buttonClick        =
         [this](auto, auto index) {
-            d_root->d_widgets.pop_back();
-            d_root->d_widgetId
-                = std::get<Canvas>(d_root->d_widgets.back()).d_widgetId;
-            d_root->d_widgets.pop_back();
+            Wawt::removePopUp(d_root);
             auto& button = d_buttons[index];
             button.callSelectFn();
             return d_buttonClick(this, index);
@@ -1035,6 +2168,9 @@ Wawt::List::popUpDropDown()
     dropDown.d_layout.d_lowerRight = { kLOWER_RIGHT, d_widgetId, 0, y };
 
     d_root->d_widgetId = nextId;
+    Wawt::setDependencies(d_root, d_root, &canvasWidget);
+    Wawt::setDependencies(d_root, d_root, &dropDownWidget);
+    Wawt::sortDependencies(d_root);
     return;                                                           // RETURN
 }
 
@@ -1050,6 +2186,7 @@ Wawt::List::initButton(unsigned int index, bool lastButton)
                 nxt.d_draw.d_selected = false;
             }
             clicked->d_draw.d_selected = true;
+            p->d_link.markDamaged();
 
             if (p->d_buttonClick) {
                 return p->d_buttonClick(p, index);
@@ -1083,6 +2220,8 @@ Wawt::List::initButton(unsigned int index, bool lastButton)
             return FocusCb();
         };
     }
+    button.d_link.d_widget            = this; // see: 'TreeLink'
+    button.d_text.d_link.d_widget     = this;
     button.d_text.fontSizeGrp()       = d_fontSizeGrp;
     button.d_layout.d_borderThickness = 1; // for click box - do not scale
     button.d_draw.d_bulletType        = BulletType::eNONE;
@@ -1133,6 +2272,8 @@ Wawt::List::setStartingRow(int           row,
                           Button       *upButton,
                           Button       *downButton)
 {
+    d_link.markDamaged();
+
     if (d_buttons.size() > d_rows) {
         bool scrollUp = false, scrollDown = false;
         
@@ -1189,6 +2330,7 @@ void
 Wawt::List::resetRows()
 {
     d_startRow = 0;
+    d_link.markDamaged();
 
     if (d_type == ListType::eDROPDOWNLIST) {
         d_buttons.erase(d_buttons.begin(),
@@ -1238,6 +2380,24 @@ Wawt::List::setButtonPositions(bool resizeListBox)
                             // class  Wawt::Panel
                             //------------------
 
+const Wawt::DrawDirective *
+Wawt::Panel::findView(WidgetId id) const
+{
+    const DrawDirective *view = nullptr;
+
+    if (!d_index.empty()) {
+        auto slot = std::size_t(id.value());
+
+        if (slot < d_index.d_views.size()) {
+            view = d_index.d_views[slot];
+        }
+    }
+    else {
+        findBox(&view, *this, id);
+    }
+    return view;                                                      // RETURN
+}
+
 bool
 Wawt::Panel::findWidget(Widget **widget, Wawt::WidgetId widgetId)
 {
@@ -1255,6 +2415,16 @@ Wawt::Panel::findWidget(Widget **widget, Wawt::WidgetId widgetId)
         return false;                                                 // RETURN
     }
 
+    if (!d_index.empty()) {
+        auto slot = std::size_t(widgetId.value());
+
+        if (slot < d_index.d_widgets.size() && d_index.d_widgets[slot]) {
+            *widget = d_index.d_widgets[slot];
+            return true;                                              // RETURN
+        }
+        return false;                                                 // RETURN
+    }
+
     for (auto& nextWidget : d_widgets) {
         if (std::holds_alternative<Panel>(nextWidget)) {
             auto& panel = std::get<Panel>(nextWidget);
@@ -1324,6 +2494,10 @@ Wawt::Panel::downEvent(int x, int y)
                     auto& obj = std::get<Panel>(widget);
                     cb = obj.downEvent(x, y);
                 } break;                                               // BREAK
+                case kTEXTEDITOR: { // TextEditor
+                    auto& obj = std::get<TextEditor>(widget);
+                    cb = obj.downEvent(x, y);
+                } break;                                               // BREAK
                 default: abort();
             }
 
@@ -1333,38 +2507,647 @@ Wawt::Panel::downEvent(int x, int y)
     return cb;                                                        // RETURN
 }
 
+                            //-----------------------
+                            // class  Wawt::ThreadPool
+                            //-----------------------
+
+// PRIVATE MANIPULATORS
+void
+Wawt::ThreadPool::work()
+{
+    std::unique_lock<std::mutex> guard(d_lock);
+
+    while (true) {
+        d_ready.wait(guard, [this]() { return d_stop || !d_queue.empty(); });
+
+        if (d_stop) {
+            return;                                                   // RETURN
+        }
+        auto task = std::move(d_queue.front());
+        d_queue.pop_front();
+        guard.unlock();
+        task();
+        guard.lock();
+
+        if (--d_pending == 0) {
+            d_done.notify_all();
+        }
+    }
+}
+
+// PUBLIC CONSTRUCTORS
+Wawt::ThreadPool::ThreadPool(unsigned int threads)
+: d_lock()
+, d_ready()
+, d_done()
+, d_queue()
+, d_pending(0)
+, d_stop(false)
+, d_threads()
+{
+    for (auto i = 1u; i < threads; ++i) {
+        d_threads.emplace_back([this]() { work(); });
+    }
+}
+
+Wawt::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(d_lock);
+        d_stop = true;
+    }
+    d_ready.notify_all();
+
+    for (auto& thread : d_threads) {
+        thread.join();
+    }
+}
+
+// PUBLIC MANIPULATORS
+void
+Wawt::ThreadPool::run(std::vector<std::function<void()>>&& tasks)
+{
+    std::unique_lock<std::mutex> guard(d_lock);
+
+    for (auto& task : tasks) {
+        d_queue.push_back(std::move(task));
+    }
+    d_pending += tasks.size();
+    d_ready.notify_all();
+
+    while (!d_queue.empty()) {
+        auto task = std::move(d_queue.front());
+        d_queue.pop_front();
+        guard.unlock();
+        task();
+        guard.lock();
+        d_pending -= 1;
+    }
+    d_done.wait(guard, [this]() { return d_pending == 0; });
+    return;                                                           // RETURN
+}
+
                                 //-----------
                                 // class  Wawt
                                 //-----------
 
 // PRIVATE CLASS METHODS
 void
-Wawt::scalePosition(Panel::Widget *widget, const Scale& scale, double border)
+Wawt::captureGeometry(FlatScreen *compiled)
 {
-    auto index = widget->index();
-    switch (index) {
-        case kCANVAS: { // Canvas
-            auto& canvas = std::get<Canvas>(*widget);
-            canvas.d_draw.d_borderThickness
-                = scaleBorder(border, canvas.d_layout.d_borderThickness);
-            scaleAdapterParameters(&canvas.d_draw, scale);
-        } break;                                                       // BREAK
-        case kTEXTENTRY: { // TextEntry
-            auto& entry = std::get<TextEntry>(*widget);
-            entry.d_draw.d_borderThickness
-                = scaleBorder(border, entry.d_layout.d_borderThickness);
-            scaleAdapterParameters(&entry.d_draw, scale);
-        } break;                                                       // BREAK
-        case kLABEL: { // Label
-            auto& label = std::get<Label>(*widget);
-            label.d_draw.d_borderThickness
-                = scaleBorder(border, label.d_layout.d_borderThickness);
-            scaleAdapterParameters(&label.d_draw, scale);
-        } break;                                                       // BREAK
-        case kBUTTON: { // Button
-            auto& btn = std::get<Button>(*widget);
-            btn.d_draw.d_borderThickness
-                = scaleBorder(border, btn.d_layout.d_borderThickness);
+    auto count = compiled->d_widgets.size();
+
+    for (auto i = 0u; i < count; ++i) {
+        auto base = compiled->d_widgets[i];
+        auto view = static_cast<const DrawDirective*>(&base->d_draw);
+        compiled->d_ux[i]      = view->d_upperLeft.d_x;
+        compiled->d_uy[i]      = view->d_upperLeft.d_y;
+        compiled->d_lx[i]      = view->d_lowerRight.d_x;
+        compiled->d_ly[i]      = view->d_lowerRight.d_y;
+        compiled->d_borders[i] = base->d_layout.d_borderThickness;
+    }
+    compiled->d_positions = compiled->d_root->d_index.d_positions;
+    return;                                                           // RETURN
+}
+
+void
+Wawt::collectBases(Panel              *panel,
+                   std::vector<Base*> *bases,
+                   std::vector<List*> *lists)
+{
+    for (auto& widget : panel->d_widgets) {
+        switch (widget.index()) {
+            case kBUTTONBAR: {
+                    auto& bar = std::get<ButtonBar>(widget);
+                    bases->push_back(&bar);
+
+                    for (auto& button : bar.d_buttons) {
+                        bases->push_back(&button);
+                    }
+                } break;                                               // BREAK
+            case kLIST: {
+                    auto& list = std::get<List>(widget);
+                    bases->push_back(&list);
+                    lists->push_back(&list);
+
+                    for (auto& button : list.d_buttons) {
+                        bases->push_back(&button);
+                    }
+                } break;                                               // BREAK
+            case kPANEL: {
+                    auto& child = std::get<Panel>(widget);
+                    bases->push_back(&child);
+                    collectBases(&child, bases, lists);
+                } break;                                               // BREAK
+            default: {
+                    bases->push_back(std::visit([](auto& w) -> Base* {
+                                                    return &w;
+                                                }, widget));
+                } break;                                               // BREAK
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::completeWidgetAdapterValues(Panel::Widget                  *widget,
+                                  const Scale&                    scale,
+                                  const BorderThicknessDefaults&  border,
+                                  const WidgetOptionDefaults&     option)
+{
+    static const char *names[] = { "'Canvas'",
+                                   "'TextEntry'",
+                                   "'Label'",
+                                   "'Button'",
+                                   "'ButtonBar'",
+                                   "'List'",
+                                   "'Panel'",
+                                   "'TextEditor'" };
+    auto& base = std::visit([](Base& r) -> Base& { return r; }, *widget);
+
+    if (!base.adapterView().verify()) {
+        throw Wawt::Exception(std::string(names[widget->index()])
+                                            + " corners are inverted.",
+                              base.d_widgetId);                        // THROW
+    }
+
+    switch (widget->index()) {
+        case kBUTTONBAR: { // ButtonBar
+            auto& bar    = std::get<Wawt::ButtonBar>(*widget);
+            int    count  = bar.d_buttons.size();
+
+            if (0 == count) {
+                break;                                                 // BREAK
+            }
+            // At this point we can only slice the bar up so that each
+            // button is close to the same size, and next to each other.  The
+            // call to Wawt::refreshTextMetrics() will finish the job of
+            // shrinking each button to the same width (height is ok) such
+            // that the longest label still fits.
+            auto& view        = bar.adapterView();
+            auto  upperLeft   = view.d_upperLeft;
+            auto  lowerRight  = view.d_lowerRight;
+            auto  width       = view.interiorWidth();
+            auto  borderScale = std::min(scale.first, scale.second);
+
+            auto thickness = bar.d_buttons.front().d_layout.d_borderThickness;
+
+            if (thickness < 0) {
+                thickness = double(border.d_buttonThickness);
+            }
+
+            thickness   = scaleBorder(borderScale, thickness);
+
+            auto  overhead    = 2.*view.d_borderThickness;
+
+            if (overhead + 2*thickness+4         > view.height()
+             || overhead + count*(2*thickness+4) > view.width()) {
+                throw Wawt::Exception("'ButtonBar' is too small.",
+                                     bar.d_widgetId);                  // THROW
+            }
+
+            upperLeft.d_y    += view.d_borderThickness;
+            lowerRight.d_x    = upperLeft.d_x + view.d_borderThickness - 1;
+            lowerRight.d_y   -= view.d_borderThickness;
+
+            for (auto& button : bar.d_buttons) {
+                auto& buttonView             = button.d_draw;
+                auto  delta                  = int(std::round(width/count));
+                upperLeft.d_x                = lowerRight.d_x + 1;
+                lowerRight.d_x              += delta;
+                width                       -= delta;
+                buttonView.d_borderThickness = thickness;
+                buttonView.d_upperLeft       = upperLeft;
+                buttonView.d_lowerRight      = lowerRight;
+                count                       -= 1;
+
+                button.d_layout.d_borderThickness = thickness;
+
+                if (!button.d_draw.d_options.has_value()
+                 && button.d_draw.d_style == 0) {
+                    if (option.d_buttonStyle != 0) {
+                        button.d_draw.d_style   = option.d_buttonStyle;
+                    }
+                    else {
+                        button.d_draw.d_options = option.d_buttonOptions;
+                    }
+                }
+                assert(button.adapterView().verify());
+            }
+        } break;                                                       // BREAK
+        case kLIST: { // List
+            auto& list = std::get<Wawt::List>(*widget);
+            list.d_rowHeight = double(list.adapterView().interiorHeight())
+                                                         / list.windowSize();
+            list.setButtonPositions();
+        } break;                                                       // BREAK
+        default: {
+        } break;                                                       // BREAK
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::compileDisplay(const Panel& root)
+{
+    auto& index = root.d_index;
+
+    index.d_display.clear();
+    compileDisplayCommands(&index.d_display, root, kPANEL);
+    index.d_displayGeneration = index.d_generation;
+    index.d_commands.assign(index.d_widgets.size(), 0); // slot 0 is root's
+    index.d_painted.clear();
+
+    for (auto i = 0u; i < index.d_display.size(); ++i) {
+        auto base = index.d_display[i].d_base;
+        auto slot = i == 0 ? 0u : unsigned(base->d_widgetId.value());
+
+        if (slot >= index.d_commands.size()) {
+            index.d_commands.resize(slot+1, 0);
+        }
+        index.d_commands[slot] = i;
+
+        if (base->d_draw.d_paintFn) { // may draw differently each frame
+            index.d_painted.push_back(i);
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::compileDisplayCommands(std::vector<Panel::DisplayCommand> *display,
+                             const Base&                         base,
+                             std::size_t                         kind)
+{
+    using Command = Panel::DisplayCommand;
+    auto  entry   = uint32_t(display->size());
+    auto  code    = kind == kBUTTONBAR  ? Command::eBUTTONBAR
+                  : kind == kLIST       ? Command::eLIST
+                  : kind == kTEXTEDITOR ? Command::eTEXTEDITOR
+                                        : Command::eWIDGET;
+
+    display->push_back(Command{code, entry+1, &base});
+
+    if (kind == kPANEL) {
+        for (auto& widget : static_cast<const Panel&>(base).d_widgets) {
+            auto& child = std::visit([](const Base& r) -> const Base& {
+                                        return r;
+                                     }, widget);
+            compileDisplayCommands(display, child, widget.index());
+        }
+        (*display)[entry].d_end = uint32_t(display->size());
+    }
+    return;                                                           // RETURN
+}
+
+bool
+Wawt::displayChanged(const Panel::DisplayCommand& command)
+{
+    // A widget is changed if it is shown, draws something (see:
+    // 'DrawOptions::draw'), and is not as it was last drawn.
+    using Command = Panel::DisplayCommand;
+    auto  changed = [](const Base& widget) {
+        auto& view = widget.adapterView();
+        auto& text = widget.d_text;
+
+        return !widget.d_draw.d_hidden
+            && (view.d_options.has_value()
+             || view.d_style != 0
+             || !text.getText().empty())
+            && drawnDiffers(view, text.generation());
+    };
+    auto  base    = command.d_base;
+
+    if (changed(*base)) {
+        return true;                                                  // RETURN
+    }
+
+    if (command.d_code == Command::eBUTTONBAR) {
+        auto& buttons = static_cast<const ButtonBar*>(base)->d_buttons;
+        return std::any_of(buttons.begin(), buttons.end(), changed);  // RETURN
+    }
+
+    if (command.d_code == Command::eLIST) {
+        auto& buttons = static_cast<const List*>(base)->d_buttons;
+        return std::any_of(buttons.begin(), buttons.end(), changed);  // RETURN
+    }
+    // A 'TextEditor' sizes its rows by its own directive.
+    return false;                                                     // RETURN
+}
+
+void
+Wawt::compileEntry(FlatScreen     *compiled,
+                   Base           *base,
+                   std::size_t     kind,
+                   uint32_t        parent)
+{
+    auto entry = uint32_t(compiled->d_widgets.size());
+    auto flags = uint8_t(kind == kPANEL ? FlatScreen::eCONTAINER
+                                        : kind == kLIST ? FlatScreen::eROWS
+                                                        : 0);
+    compiled->d_widgets.push_back(base);
+    compiled->d_kinds.push_back(uint8_t(kind));
+    compiled->d_flags.push_back(flags);
+    compiled->d_parents.push_back(parent);
+    compiled->d_ends.push_back(entry+1);
+
+    if (kind == kPANEL) {
+        for (auto& widget : static_cast<Panel*>(base)->d_widgets) {
+            auto& child = std::visit([](Base& r) -> Base& { return r; },
+                                     widget);
+            compileEntry(compiled, &child, widget.index(), entry);
+        }
+    }
+    else if (kind == kBUTTONBAR) {
+        for (auto& btn : static_cast<ButtonBar*>(base)->d_buttons) {
+            compileEntry(compiled, &btn, kBUTTON, entry);
+            compiled->d_flags.back() = FlatScreen::eROW;
+        }
+    }
+    compiled->d_ends[entry] = uint32_t(compiled->d_widgets.size());
+    return;                                                           // RETURN
+}
+
+bool
+Wawt::compileLayout(Panel *root)
+{
+    auto& index = root->d_index;
+    auto& steps = index.d_layoutSteps;
+
+    steps.clear();
+    index.d_layoutGroups.clear();
+
+    // Note which of the root's widgets each slot descends from:
+    std::vector<uint32_t>                   subtrees(index.d_widgets.size());
+    std::vector<Panel::Index::StepRange>    ranges;
+
+    for (auto& widget : root->d_widgets) {
+        auto begin = uint32_t(steps.size());
+
+        if (!compileLayoutSteps(root, root, &widget)) {
+            // Let the interpreter report the problem.
+            steps.clear();
+            return false;                                             // RETURN
+        }
+
+        for (auto i = begin; i < steps.size(); ++i) {
+            if (steps[i].d_code == Panel::LayoutStep::eWIDGET) {
+                subtrees[steps[i].d_base->d_widgetId.value()] = ranges.size();
+            }
+        }
+        ranges.emplace_back(begin, uint32_t(steps.size()));
+    }
+
+    // Subtrees that reference each other (other than through the root)
+    // must be laid out together, in order:
+    std::vector<uint32_t> joined(ranges.size());
+
+    for (auto i = 0u; i < joined.size(); ++i) {
+        joined[i] = i;
+    }
+    auto find = [&joined](uint32_t i) {
+        while (joined[i] != i) {
+            i = joined[i] = joined[joined[i]];
+        }
+        return i;
+    };
+
+    for (auto slot = 1u; slot < index.d_dependents.size(); ++slot) {
+        for (auto dependent : index.d_dependents[slot]) {
+            auto first  = find(subtrees[slot]);
+            auto second = find(subtrees[dependent]);
+
+            if (first != second) {
+                joined[std::max(first, second)] = std::min(first, second);
+            }
+        }
+    }
+    std::vector<uint32_t> groupOf(ranges.size(), UINT32_MAX);
+
+    for (auto i = 0u; i < ranges.size(); ++i) {
+        auto& group = groupOf[find(i)];
+
+        if (group == UINT32_MAX) {
+            group = index.d_layoutGroups.size();
+            index.d_layoutGroups.emplace_back();
+        }
+        index.d_layoutGroups[group].push_back(ranges[i]);
+    }
+    index.d_layoutGeneration = index.d_generation;
+    return true;                                                      // RETURN
+}
+
+bool
+Wawt::compileLayoutSteps(Panel *root, Panel *parent, Panel::Widget *widget)
+{
+    // The steps are in the order 'setWidgetAdapterPositions' interprets
+    // the widgets, and the corner contexts are resolved once, here.
+    using Step  = Panel::LayoutStep;
+    auto& steps = root->d_index.d_layoutSteps;
+    auto& base  = std::visit([](Base& r) -> Base& { return r; }, *widget);
+    auto  upper = findAdapterView(*parent,
+                                  *root,
+                                  base.d_layout.d_upperLeft.d_widgetId);
+    auto  lower = findAdapterView(*parent,
+                                  *root,
+                                  base.d_layout.d_lowerRight.d_widgetId);
+
+    if (!upper || !lower) {
+        return false;                                                 // RETURN
+    }
+    steps.push_back({Step::eWIDGET, widget, &base, nullptr});
+    steps.push_back({Step::eUPPER,  widget, &base, upper});
+    steps.push_back({Step::eLOWER,  widget, &base, lower});
+
+    if (base.d_layout.d_tie != TieScale::eNONE) {
+        steps.push_back({Step::eTIE, widget, &base, nullptr});
+    }
+    steps.push_back({Step::eDONE,   widget, &base, nullptr});
+
+    if (widget->index() == kPANEL) {
+        auto& panel = std::get<Panel>(*widget);
+
+        for (auto& nextWidget : panel.d_widgets) {
+            if (!compileLayoutSteps(root, &panel, &nextWidget)) {
+                return false;                                         // RETURN
+            }
+        }
+    }
+    return true;                                                      // RETURN
+}
+
+bool
+Wawt::isCurrent(const FlatScreen& compiled)
+{
+    return compiled.d_root
+        && compiled.d_generation == compiled.d_root->d_index.d_generation;
+}
+
+bool
+Wawt::relinkLayout(Panel *root, std::size_t slot)
+{
+    using Step    = Panel::LayoutStep;
+    auto& index   = root->d_index;
+    auto  parent  = index.d_parents[slot] ? index.d_parents[slot] : root;
+    auto& base    = std::visit([](Base& r) -> Base& { return r; },
+                               *index.d_widgets[slot]);
+    auto& layout  = base.d_layout;
+    auto  slots   = index.d_widgets.size();
+    auto  first   = layoutDependency(*parent,
+                                     *root,
+                                     layout.d_upperLeft.d_widgetId,
+                                     slots);
+    auto  second  = layoutDependency(*parent,
+                                     *root,
+                                     layout.d_lowerRight.d_widgetId,
+                                     slots);
+    auto  linked  = std::vector<std::size_t>(); // by the previous layout
+    auto  wanted  = std::vector<std::size_t>();
+
+    for (auto i = 0u; i < index.d_dependents.size(); ++i) {
+        auto& dependents = index.d_dependents[i];
+
+        if (std::find(dependents.begin(), dependents.end(), slot)
+                                                        != dependents.end()) {
+            linked.push_back(i);
+        }
+    }
+
+    if (first >= 0) {
+        wanted.push_back(first);
+    }
+
+    if (second >= 0 && second != first) {
+        wanted.push_back(second);
+    }
+    std::sort(wanted.begin(), wanted.end());
+
+    if (linked != wanted) {
+        // Each list of dependents is kept in slot order, so the edges of
+        // pop-ups stay last (see: 'Index::truncate').
+        auto relink = [&index, slot](const std::vector<std::size_t>& from,
+                                     const std::vector<std::size_t>& to) {
+            for (auto i : from) {
+                auto& dependents = index.d_dependents[i];
+                dependents.erase(std::find(dependents.begin(),
+                                           dependents.end(),
+                                           slot));
+            }
+
+            for (auto i : to) {
+                auto& dependents = index.d_dependents[i];
+                dependents.insert(std::lower_bound(dependents.begin(),
+                                                   dependents.end(),
+                                                   slot),
+                                  uint16_t(slot));
+            }
+        };
+        relink(linked, wanted);
+
+        try {
+            sortDependencies(root);
+        }
+        catch (...) {
+            relink(wanted, linked);
+            sortDependencies(root);
+            throw;                                                    // THROW
+        }
+    }
+
+    // The steps hold the corners' contexts, and a tie only if there is
+    // one (see: 'compileLayoutSteps').
+    auto& steps = index.d_layoutSteps;
+    auto  step  = std::find_if(steps.begin(),
+                               steps.end(),
+                               [&base](const Step& compiled) {
+                                   return compiled.d_base == &base;
+                               });
+
+    if (step == steps.end()) {
+        return true;                                                  // RETURN
+    }
+    auto upper = findAdapterView(*parent,
+                                 *root,
+                                 layout.d_upperLeft.d_widgetId);
+    auto lower = findAdapterView(*parent,
+                                 *root,
+                                 layout.d_lowerRight.d_widgetId);
+    auto tie   = layout.d_tie != TieScale::eNONE;
+
+    return step[1].d_reference != upper
+        || step[2].d_reference != lower
+        || (step[3].d_code == Step::eTIE) != tie;                     // RETURN
+}
+
+void
+Wawt::rescaleCompiled(FlatScreen     *compiled,
+                      const Scale&    scale,
+                      double          borderScale)
+{
+    captureGeometry(compiled);
+
+    auto  count = compiled->d_widgets.size();
+    auto *ux    = compiled->d_ux.data();
+    auto *uy    = compiled->d_uy.data();
+    auto *lx    = compiled->d_lx.data();
+    auto *ly    = compiled->d_ly.data();
+
+    // The root (entry 0) is sized by the caller.
+    if (count > 1) {
+        scaleSpans(ux+1, lx+1, count-1, scale.first);
+        scaleSpans(uy+1, ly+1, count-1, scale.second);
+        scaleBorders(compiled->d_borders.data()+1,
+                     compiled->d_scaled.data()+1,
+                     count-1,
+                     borderScale);
+    }
+
+    for (auto i = 1u; i < count; ++i) {
+        auto  base = compiled->d_widgets[i];
+        auto& view = base->d_draw;
+        view.d_upperLeft.d_x     = ux[i];
+        view.d_upperLeft.d_y     = uy[i];
+        view.d_lowerRight.d_x    = lx[i];
+        view.d_lowerRight.d_y    = ly[i];
+        view.d_borderThickness   = compiled->d_scaled[i];
+
+        if (compiled->d_flags[i] & FlatScreen::eROWS) {
+            auto list = static_cast<List*>(base);
+            list->d_rowHeight = double(list->d_draw.interiorHeight())
+                                                      / list->windowSize();
+            list->setButtonPositions(); // List buttons have no borders.
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::scalePosition(Panel::Widget *widget, const Scale& scale, double border)
+{
+    auto index = widget->index();
+    switch (index) {
+        case kCANVAS: { // Canvas
+            auto& canvas = std::get<Canvas>(*widget);
+            canvas.d_draw.d_borderThickness
+                = scaleBorder(border, canvas.d_layout.d_borderThickness);
+            scaleAdapterParameters(&canvas.d_draw, scale);
+        } break;                                                       // BREAK
+        case kTEXTENTRY: { // TextEntry
+            auto& entry = std::get<TextEntry>(*widget);
+            entry.d_draw.d_borderThickness
+                = scaleBorder(border, entry.d_layout.d_borderThickness);
+            scaleAdapterParameters(&entry.d_draw, scale);
+        } break;                                                       // BREAK
+        case kLABEL: { // Label
+            auto& label = std::get<Label>(*widget);
+            label.d_draw.d_borderThickness
+                = scaleBorder(border, label.d_layout.d_borderThickness);
+            scaleAdapterParameters(&label.d_draw, scale);
+        } break;                                                       // BREAK
+        case kBUTTON: { // Button
+            auto& btn = std::get<Button>(*widget);
+            btn.d_draw.d_borderThickness
+                = scaleBorder(border, btn.d_layout.d_borderThickness);
             scaleAdapterParameters(&btn.d_draw, scale);
         } break;                                                       // BREAK
         case kBUTTONBAR: { // ButtonBar
@@ -1399,13 +3182,70 @@ Wawt::scalePosition(Panel::Widget *widget, const Scale& scale, double border)
                 scalePosition(&nextWidget, scale, border);
             }
         } break;                                                       // BREAK
+        case kTEXTEDITOR: { // TextEditor
+            auto& editor = std::get<TextEditor>(*widget);
+            editor.d_draw.d_borderThickness
+                = scaleBorder(border, editor.d_layout.d_borderThickness);
+            scaleAdapterParameters(&editor.d_draw, scale);
+        } break;                                                       // BREAK
         default: abort();
     }
     return;                                                           // RETURN
 }
 
 void
-Wawt::setIds(Panel::Widget *widget, Wawt::WidgetId& id)
+Wawt::setDependencies(Panel *root, Panel *parent, Panel::Widget *widget)
+{
+    auto& index  = root->d_index;
+    auto& base   = std::visit([](Base& r) -> Base& { return r; }, *widget);
+    auto  slot   = base.d_widgetId.value();
+    auto  slots  = index.d_widgets.size();
+    auto  first  = layoutDependency(*parent,
+                                    *root,
+                                    base.d_layout.d_upperLeft.d_widgetId,
+                                    slots);
+    auto  second = layoutDependency(*parent,
+                                    *root,
+                                    base.d_layout.d_lowerRight.d_widgetId,
+                                    slots);
+
+    index.d_parents[slot] = parent == root ? nullptr : parent;
+
+    base.d_link.d_widget        = &base;
+    base.d_link.d_parent        = parent;
+    base.d_text.d_link.d_widget = &base;
+
+    if (widget->index() == kBUTTONBAR || widget->index() == kLIST) {
+        auto& buttons = widget->index() == kLIST
+                                ? std::get<List>(*widget).d_buttons
+                                : std::get<ButtonBar>(*widget).d_buttons;
+
+        for (auto& button : buttons) { // a button change redoes them all
+            button.d_link.d_widget        = &base;
+            button.d_text.d_link.d_widget = &base;
+        }
+    }
+
+    if (first >= 0) {
+        index.d_dependents[first].push_back(slot);
+    }
+
+    if (second >= 0 && second != first) {
+        index.d_dependents[second].push_back(slot);
+    }
+
+    if (widget->index() == kPANEL) {
+        auto& panel = std::get<Panel>(*widget);
+
+        for (auto& nextWidget : panel.d_widgets) {
+            setDependencies(root, &panel, &nextWidget);
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::setIds(Panel::Widget *widget, Wawt::WidgetId& id, Panel *root)
 {
     auto index = widget->index();
     switch (index) {
@@ -1453,13 +3293,20 @@ Wawt::setIds(Panel::Widget *widget, Wawt::WidgetId& id)
             auto& panel = std::get<Wawt::Panel>(*widget);
 
             for (auto& nextWidget : panel.d_widgets) {
-                setIds(&nextWidget, id);
+                setIds(&nextWidget, id, root);
             }
             panel.d_widgetId        = Wawt_Id::inc(id);
             panel.d_draw.d_tracking = {index, panel.d_widgetId.value(), -1};
         } break;                                                   // BREAK
+        case kTEXTEDITOR: { // TextEditor
+            auto& editor = std::get<TextEditor>(*widget);
+            editor.d_widgetId        = Wawt_Id::inc(id);
+            editor.d_draw.d_tracking = {index, editor.d_widgetId.value(), -1};
+        } break;                                                   // BREAK
         default: abort();
     }
+    auto& base = std::visit([](Base& r) -> Base& { return r; }, *widget);
+    root->d_index.insert(base.d_widgetId, widget, &base.adapterView());
     return;                                                           // RETURN
 }
 
@@ -1471,231 +3318,239 @@ Wawt::setWidgetAdapterPositions(Panel::Widget                  *widget,
                                const BorderThicknessDefaults&  border,
                                const WidgetOptionDefaults&     option)
 {
-    switch (widget->index()) {
-        case kCANVAS: { // Canvas
-            auto& canvas = std::get<Wawt::Canvas>(*widget);
-            auto& base   = static_cast<Wawt::Base&>(canvas);
-            auto& layout = base.d_layout;
-            auto& draw   = base.d_draw;
+    setWidgetAdapterValues(widget, root, panel, scale, border, option);
 
-            if (layout.d_borderThickness < 0) {
-                layout.d_borderThickness = double(border.d_canvasThickness);
-            }
+    if (widget->index() == kPANEL) {
+        auto& next = std::get<Wawt::Panel>(*widget);
 
-            if (!draw.d_options.has_value()) {
-                draw.d_options = option.d_canvasOptions;
-            }
-
-            setAdapterValues(&draw, &layout, panel, *root, scale);
-
-            if (!canvas.adapterView().verify()) {
-                throw Wawt::Exception("'Canvas' corners are inverted.",
-                                canvas.d_widgetId);                    // THROW
-            }
-        } break;                                                       // BREAK
-        case kTEXTENTRY: { // TextEntry
-            auto& entry  = std::get<Wawt::TextEntry>(*widget);
-            auto& base   = static_cast<Wawt::Base&>(entry);
-            auto& layout = base.d_layout;
-            auto& draw   = base.d_draw;
+        for (auto& nextWidget : next.d_widgets) {
+            setWidgetAdapterPositions(&nextWidget,
+                                      root,
+                                      next,
+                                      scale,
+                                      border,
+                                      option);
+        }
+    }
+    return;                                                           // RETURN
+}
 
-            if (layout.d_borderThickness < 0) {
-                layout.d_borderThickness = double(border.d_textEntryThickness);
-            }
+void
+Wawt::setWidgetAdapterValues(Panel::Widget                  *widget,
+                             Panel                          *root,
+                             const Panel&                    panel,
+                             const Scale&                    scale,
+                             const BorderThicknessDefaults&  border,
+                             const WidgetOptionDefaults&     option)
+{
+    auto& base = std::visit([](Base& r) -> Base& { return r; }, *widget);
 
-            if (!draw.d_options.has_value()) {
-                draw.d_options = option.d_textEntryOptions;
-            }
+    setWidgetDefaults(widget, &base, border, option);
+    setAdapterValues(&base.d_draw, &base.d_layout, panel, *root, scale);
+    completeWidgetAdapterValues(widget, scale, border, option);
+    return;                                                           // RETURN
+}
 
-            setAdapterValues(&draw, &layout, panel, *root, scale);
+void
+Wawt::setWidgetDefaults(Panel::Widget                  *widget,
+                        Base                           *base,
+                        const BorderThicknessDefaults&  border,
+                        const WidgetOptionDefaults&     option)
+{
+    unsigned int    thickness = 0;
+    const std::any *options   = nullptr;
+    StyleId         style     = 0;
 
-            if (!entry.adapterView().verify()) {
-                throw Wawt::Exception("'TextEntry' corners are inverted.",
-                                entry.d_widgetId);                     // THROW
-            }
+    switch (widget->index()) {
+        case kCANVAS: { // Canvas
+            thickness = border.d_canvasThickness;
+            options   = &option.d_canvasOptions;
+            style     = option.d_canvasStyle;
+        } break;                                                       // BREAK
+        case kTEXTENTRY: { // TextEntry
+            thickness = border.d_textEntryThickness;
+            options   = &option.d_textEntryOptions;
+            style     = option.d_textEntryStyle;
         } break;                                                       // BREAK
         case kLABEL: { // Label
-            auto& label  = std::get<Wawt::Label>(*widget);
-            auto& base   = static_cast<Wawt::Base&>(label);
-            auto& layout = base.d_layout;
-            auto& draw   = base.d_draw;
-
-            if (layout.d_borderThickness < 0) {
-                layout.d_borderThickness = double(border.d_labelThickness);
-            }
-
-            if (!draw.d_options.has_value()) {
-                draw.d_options = option.d_labelOptions;
-            }
-
-            setAdapterValues(&draw, &layout, panel, *root, scale);
-
-            if (!label.adapterView().verify()) {
-                throw Wawt::Exception("'Label' corners are inverted.",
-                                label.d_widgetId);                     // THROW
-            }
+            thickness = border.d_labelThickness;
+            options   = &option.d_labelOptions;
+            style     = option.d_labelStyle;
         } break;                                                       // BREAK
         case kBUTTON: { // Button
-            auto& button = std::get<Wawt::Button>(*widget);
-            auto& base   = static_cast<Wawt::Base&>(button);
-            auto& layout = base.d_layout;
-            auto& draw   = base.d_draw;
-
-            if (layout.d_borderThickness < 0) {
-                layout.d_borderThickness = double(border.d_buttonThickness);
-            }
-
-            if (!draw.d_options.has_value()) {
-                draw.d_options = option.d_buttonOptions;
-            }
-
-            setAdapterValues(&draw, &layout, panel, *root, scale);
-
-            if (!button.adapterView().verify()) {
-                throw Wawt::Exception("'Button' corners are inverted.",
-                                button.d_widgetId);                    // THROW
-            }
+            thickness = border.d_buttonThickness;
+            options   = &option.d_buttonOptions;
+            style     = option.d_buttonStyle;
         } break;                                                       // BREAK
         case kBUTTONBAR: { // ButtonBar
-            auto& bar    = std::get<Wawt::ButtonBar>(*widget);
-            auto& base   = static_cast<Wawt::Base&>(bar);
-            auto& layout = base.d_layout;
-            auto& draw   = base.d_draw;
-
-            if (layout.d_borderThickness < 0) {
-                layout.d_borderThickness =  double(border.d_buttonBarThickness);
-            }
-
-            if (!draw.d_options.has_value()) {
-                draw.d_options = option.d_buttonBarOptions;
-            }
-
-            setAdapterValues(&draw, &layout, panel, *root, scale);
-
-            if (!bar.adapterView().verify()) {
-                throw Wawt::Exception("'ButtonBar' corners are inverted.",
-                                bar.d_widgetId);                       // THROW
-            }
-            int    count  = bar.d_buttons.size();
-
-            if (0 == count) {
-                break;                                                 // BREAK
-            }
-            // At this point we can only slice the bar up so that each
-            // button is close to the same size, and next to each other.  The
-            // call to Wawt::refreshTextMetrics() will finish the job of
-            // shrinking each button to the same width (height is ok) such
-            // that the longest label still fits.
-            auto& view        = bar.adapterView();
-            auto  upperLeft   = view.d_upperLeft;
-            auto  lowerRight  = view.d_lowerRight;
-            auto  width       = view.interiorWidth();
-            auto  borderScale = std::min(scale.first, scale.second);
-
-            auto thickness = bar.d_buttons.front().d_layout.d_borderThickness;
-
-            if (thickness < 0) {
-                thickness = double(border.d_buttonThickness);
-            }
-
-            thickness   = scaleBorder(borderScale, thickness);
-
-            auto  overhead    = 2.*view.d_borderThickness;
-
-            if (overhead + 2*thickness+4         > view.height()
-             || overhead + count*(2*thickness+4) > view.width()) {
-                throw Wawt::Exception("'ButtonBar' is too small.",
-                                     bar.d_widgetId);                  // THROW
-            }
-
-            upperLeft.d_y    += view.d_borderThickness;
-            lowerRight.d_x    = upperLeft.d_x + view.d_borderThickness - 1;
-            lowerRight.d_y   -= view.d_borderThickness;
-
-            for (auto& button : bar.d_buttons) {
-                auto& buttonView             = button.d_draw;
-                auto  delta                  = int(std::round(width/count));
-                upperLeft.d_x                = lowerRight.d_x + 1;
-                lowerRight.d_x              += delta;
-                width                       -= delta;
-                buttonView.d_borderThickness = thickness;
-                buttonView.d_upperLeft       = upperLeft;
-                buttonView.d_lowerRight      = lowerRight;
-                count                       -= 1;
-
-                button.d_layout.d_borderThickness = thickness;
-
-                if (!button.d_draw.d_options.has_value()) {
-                    button.d_draw.d_options = option.d_buttonOptions;
-                }
-                assert(button.adapterView().verify());
-            }
+            thickness = border.d_buttonBarThickness;
+            options   = &option.d_buttonBarOptions;
+            style     = option.d_buttonBarStyle;
         } break;                                                       // BREAK
         case kLIST: { // List
             auto& list     = std::get<Wawt::List>(*widget);
-            auto& base     = static_cast<Wawt::Base&>(list);
-            auto& layout   = base.d_layout;
-            auto& draw     = base.d_draw;
             auto  usePanel = (list.d_type == ListType::eCHECKLIST
                            || list.d_type == ListType::eRADIOLIST);
+            thickness = usePanel ? border.d_panelThickness
+                                 : border.d_listThickness;
+            options   = usePanel ? &option.d_panelOptions
+                                 : &option.d_listOptions;
+            style     = usePanel ? option.d_panelStyle
+                                 : option.d_listStyle;
+        } break;                                                       // BREAK
+        case kPANEL: { // Panel
+            thickness = border.d_panelThickness;
+            options   = &option.d_panelOptions;
+            style     = option.d_panelStyle;
+        } break;                                                       // BREAK
+        case kTEXTEDITOR: { // TextEditor (styled as a 'TextEntry')
+            thickness = border.d_textEntryThickness;
+            options   = &option.d_textEntryOptions;
+            style     = option.d_textEntryStyle;
+        } break;                                                       // BREAK
+        default: abort();
+    }
+
+    if (base->d_layout.d_borderThickness < 0) {
+        base->d_layout.d_borderThickness = double(thickness);
+    }
+
+    if (!base->d_draw.d_options.has_value() && base->d_draw.d_style == 0) {
+        if (style != 0) {
+            base->d_draw.d_style   = style;
+        }
+        else {
+            base->d_draw.d_options = *options;
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::sortDependencies(Panel *root)
+{
+    // Rank the widgets so each follows all those its layout references
+    // (Kahn's algorithm).  Any widget left unranked is part of a cycle.
+    auto&                 index = root->d_index;
+    auto                  slots = index.d_widgets.size();
+    std::vector<uint16_t> inDegree(std::max(slots, std::size_t(1)), 0);
+    std::vector<uint16_t> ready;
+
+    for (auto& dependents : index.d_dependents) {
+        for (auto dependent : dependents) {
+            inDegree[dependent] += 1;
+        }
+    }
+    ready.push_back(0); // the root panel references nothing.
 
-            if (layout.d_borderThickness < 0) {
-                layout.d_borderThickness
-                    = double(usePanel ? border.d_panelThickness
-                                      : border.d_listThickness);
-            }
+    for (auto slot = 1u; slot < slots; ++slot) {
+        if (index.d_widgets[slot] && inDegree[slot] == 0) {
+            ready.push_back(slot);
+        }
+    }
+    uint16_t rank = 0;
 
-            if (!draw.d_options.has_value()) {
-                draw.d_options = usePanel ? option.d_panelOptions
-                                          : option.d_listOptions;
-            }
+    while (!ready.empty()) {
+        auto slot = ready.back();
+        ready.pop_back();
 
-            setAdapterValues(&draw, &layout, panel, *root, scale);
+        if (slot < slots) {
+            index.d_ranks[slot] = rank;
 
-            if (!list.adapterView().verify()) {
-                throw Wawt::Exception("'List' corners are inverted.",
-                                list.d_widgetId);                      // THROW
+            for (auto dependent : index.d_dependents[slot]) {
+                if (--inDegree[dependent] == 0) {
+                    ready.push_back(dependent);
+                }
             }
-            list.d_rowHeight = double(list.adapterView().interiorHeight())
-                                                         / list.windowSize();
-            list.setButtonPositions();
-        } break;                                                       // BREAK
-        case kPANEL: { // Panel
-            auto& next   = std::get<Wawt::Panel>(*widget);
-            auto& base   = static_cast<Wawt::Base&>(next);
-            auto& layout = base.d_layout;
-            auto& draw   = base.d_draw;
+        }
+        rank += 1;
+    }
 
-            if (layout.d_borderThickness < 0) {
-                layout.d_borderThickness = double(border.d_panelThickness);
-            }
+    for (auto slot = 1u; slot < slots; ++slot) {
+        if (inDegree[slot] > 0) {
+            throw Exception("Layout dependency cycle.",
+                            WidgetId(slot, true, false));              // THROW
+        }
+    }
+    return;                                                           // RETURN
+}
 
-            if (!draw.d_options.has_value()) {
-                draw.d_options = option.d_panelOptions;
-            }
+// PUBLiC CLASS METHODS
+void
+Wawt::compileScreen(FlatScreen *compiled, Panel *root)
+{
+    compiled->clear();
+    compiled->d_root       = root;
+    compiled->d_generation = root->d_index.d_generation;
+    compileEntry(compiled, root, kPANEL, 0);
+
+    auto count = compiled->d_widgets.size();
+    compiled->d_ux.resize(count);
+    compiled->d_uy.resize(count);
+    compiled->d_lx.resize(count);
+    compiled->d_ly.resize(count);
+    compiled->d_borders.resize(count);
+    compiled->d_scaled.resize(count);
+    compiled->d_reachable.resize(count);
+    captureGeometry(compiled);
+    return;                                                           // RETURN
+}
 
-            setAdapterValues(&draw, &layout, panel, *root, scale);
+Wawt::EventUpCb
+Wawt::downEvent(FlatScreen *compiled, int x, int y)
+{
+    if (!isCurrent(*compiled)) {
+        compileScreen(compiled, compiled->d_root);
+    }
+    else if (compiled->d_positions != compiled->d_root->d_index.d_positions) {
+        captureGeometry(compiled);
+    }
+    auto  count     = compiled->d_widgets.size();
+    auto& reachable = compiled->d_reachable;
+
+    // First pass: a panel passes events to its children if it is enabled,
+    // contains the point, and its own parent passes events on.
+    for (auto i = 0u; i < count; ++i) {
+        if (compiled->d_flags[i] & FlatScreen::eCONTAINER) {
+            auto parent = compiled->d_parents[i];
+            reachable[i] = (i == 0 || reachable[parent])
+                        && !compiled->d_widgets[i]->d_input.disabled()
+                        && x >= compiled->d_ux[i] && x <= compiled->d_lx[i]
+                        && y >= compiled->d_uy[i] && y <= compiled->d_ly[i];
+        }
+    }
+    EventUpCb cb;
 
-            if (!next.adapterView().verify()) {
-                throw Wawt::Exception("'Panel' corners are inverted.",
-                                     next.d_widgetId);                 // THROW
-            }
+    // Second pass: reverse draw order is the order 'Panel::downEvent' uses.
+    for (auto i = count; i-- > 1 && !cb;) {
+        auto flags = compiled->d_flags[i];
 
-            for (auto& nextWidget : next.d_widgets) {
-                setWidgetAdapterPositions(&nextWidget,
-                                          root,
-                                          next,
-                                          scale,
-                                          border,
-                                          option);
-            }
-        } break;                                                       // BREAK
-        default: abort();
+        if ((flags & (FlatScreen::eCONTAINER | FlatScreen::eROW))
+         || !reachable[compiled->d_parents[i]]) {
+            continue;                                             // CONTINUE
+        }
+        auto base = compiled->d_widgets[i];
+
+        switch (compiled->d_kinds[i]) {
+            case kCANVAS:    cb = base->downEvent(x, y);                 break;
+            case kTEXTENTRY: // FALLTHROUGH
+            case kLABEL:     // FALLTHROUGH
+            case kBUTTON:    cb = static_cast<Text*>(base)->downEvent(x, y);
+                             break;
+            case kBUTTONBAR: cb = static_cast<ButtonBar*>(base)
+                                                        ->downEvent(x, y);
+                             break;
+            case kLIST:      cb = static_cast<List*>(base)->downEvent(x, y);
+                             break;
+            case kTEXTEDITOR:cb = static_cast<TextEditor*>(base)
+                                                        ->downEvent(x, y);
+                             break;
+            default: abort();
+        }
     }
-    return;                                                           // RETURN
+    return cb;                                                        // RETURN
 }
 
-// PUBLiC CLASS METHODS
 Wawt::Panel
 Wawt::scrollableList(List          list,
                     bool          buttonsOnLeft,
@@ -1705,7 +3560,8 @@ Wawt::scrollableList(List          list,
         throw
             Wawt::Exception("Scrollable list does not have 'root' set.");//THROW
     }
-    Panel container({list.d_layout.d_upperLeft, list.d_layout.d_lowerRight});
+    Panel container(Layout(list.d_layout.d_upperLeft,
+                           list.d_layout.d_lowerRight));
     auto  border = unsigned(std::round(list.d_layout.d_borderThickness));
 
     auto      scrollUpCb   = [root=list.d_root,lines](auto btn) {
@@ -1727,6 +3583,9 @@ Wawt::scrollableList(List          list,
                          {std::wstring(1, s_downArrow)},
                          {options});
 
+    scrollUp.drawView().style()   = listView.d_style;
+    scrollDown.drawView().style() = listView.d_style;
+
     auto rowHeight  = 2.0/double(list.windowSize()); // as a scale factor
     auto scale      = Metric(1.0 - rowHeight);
     auto any_M      = Metric(0); // value is just a placeholder
@@ -1768,10 +3627,19 @@ Wawt::scrollableList(List          list,
 void
 Wawt::removePopUp(Panel *root)
 {
+    auto& changes = root->d_link.d_changes;
+    auto  widget  = root->d_widgets.rbegin();
+
+    for (auto i = 0; i < 2; ++i, ++widget) { // the pop-up, and its canvas
+        auto base = std::visit([](Base& r) { return &r; }, *widget);
+        changes.erase(std::remove(changes.begin(), changes.end(), base),
+                      changes.end());
+    }
     root->d_widgets.pop_back();
     root->d_widgetId
         = std::get<Canvas>(root->d_widgets.back()).d_widgetId;
     root->d_widgets.pop_back();
+    root->d_index.truncate(root->d_widgetId);
     return;                                                           // RETURN
 }
 
@@ -1790,40 +3658,631 @@ Wawt::setScrollableListStartingRow(Wawt::List *list, unsigned int row)
 const Wawt::WidgetId   Wawt::kPARENT(UINT16_MAX, true, true);
 const Wawt::WidgetId   Wawt::kROOT(UINT16_MAX-1, true, true);
 
-const std::any        Wawt::s_noOptions;
+const std::any        Wawt::s_noOptions;
+
+wchar_t Wawt::s_downArrow = L'v';
+wchar_t Wawt::s_upArrow   = L'^';
+wchar_t Wawt::s_cursor    = L'|';
+
+// PUBLIC CONSTRUCTOR
+Wawt::Wawt(const TextMapper& mappingFn, DrawAdapter *adapter)
+: d_adapter_p(adapter ? adapter : &s_defaultAdapter)
+, d_textTable(mappingFn)
+, d_fontIdToSize()
+, d_borderDefaults()
+, d_resizePolicy()
+, d_resizeCounters()
+, d_drawCounters()
+, d_damageRoot(nullptr)
+, d_damageFrame(0)
+, d_damage()
+, d_cullOccluded(false)
+, d_occluded()
+, d_occluders()
+, d_opaque()
+, d_clipPanels(false)
+, d_clips()
+, d_batch()
+, d_styleTable()
+, d_textMetricsCache()
+, d_layoutPool()
+{
+}
+
+Wawt::~Wawt()
+{
+}
+
+// PUBLIC METHODS
+
+void
+Wawt::draw(const Panel& panel)
+{
+    if (!panel.d_index.empty()) {
+        drawDisplay(panel);
+        return;                                                       // RETURN
+    }
+    auto ptr = d_adapter_p;
+
+    if (panel.draw(ptr)) {
+        for (auto const& widget : panel.d_widgets) {
+            switch (widget.index()) {
+                case kCANVAS:    std::get<Canvas>(widget).draw(ptr);    break;
+                case kTEXTENTRY: std::get<TextEntry>(widget).draw(ptr); break;
+                case kLABEL:     std::get<Label>(widget).draw(ptr);     break;
+                case kBUTTON:    std::get<Button>(widget).draw(ptr);    break;
+                case kBUTTONBAR: std::get<ButtonBar>(widget).draw(ptr); break;
+                case kLIST:      std::get<List>(widget).draw(ptr);      break;
+                case kPANEL:     draw(std::get<Panel>(widget));         break;
+                case kTEXTEDITOR:std::get<TextEditor>(widget).draw(ptr);break;
+                default: abort();
+            }
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::draw(FlatScreen *compiled)
+{
+    if (!isCurrent(*compiled)) {
+        compileScreen(compiled, compiled->d_root);
+    }
+    drawDisplay(*compiled->d_root);
+    return;                                                           // RETURN
+}
+
+void
+Wawt::drawDisplay(const Panel& root)
+{
+    using Command = Panel::DisplayCommand;
+    auto& index   = root.d_index;
+    auto  ptr     = d_adapter_p;
+    auto  retain  = ptr->retainsFrame();
+    auto  partial = false;
+
+    auto  previous = std::vector<Command>();
+
+    if (index.d_display.empty()
+     || index.d_displayGeneration != index.d_generation) {
+        previous = std::move(index.d_display);
+        compileDisplay(root);
+
+        if (previous.empty()) { // what was drawn is unknown
+            d_damageRoot = nullptr;
+        }
+    }
+
+    if (retain) {
+        auto whole = collectDamage(root, previous);
+        partial    = ptr->damage(d_damage, whole) && !whole;
+    }
+    else {
+        index.takeDamaged(); // there is no frame to repair
+    }
+    d_drawCounters.d_frames += 1;
+
+    if (partial) {
+        d_drawCounters.d_partial += 1;
+
+        if (d_damage.empty()) {
+            return;                                                   // RETURN
+        }
+    }
+    if (d_cullOccluded) {
+        markOccluded(root);
+    }
+    auto display  = index.d_display.data();
+    auto count    = index.d_display.size();
+    auto batches  = ptr->drawsBatches();
+    auto recorder = BatchRecorder(&d_batch);
+    auto flush    = [this, ptr]() {
+        if (d_batch.size() > 0) {
+            ptr->drawBatch(d_batch);
+            d_batch.clear();
+            d_drawCounters.d_batches += 1;
+        }
+    };
+    auto painted  = [](const Command& command) {
+        auto rows = static_cast<const std::vector<Button>*>(nullptr);
+
+        if (command.d_code == Command::eBUTTONBAR) {
+            rows = &static_cast<const ButtonBar*>(command.d_base)->d_buttons;
+        }
+        else if (command.d_code == Command::eLIST) {
+            rows = &static_cast<const List*>(command.d_base)->d_buttons;
+        }
+        return command.d_base->d_draw.d_paintFn
+            || (rows && std::any_of(rows->begin(),
+                                    rows->end(),
+                                    [](const Button& button) {
+                                        return bool(button.d_draw.d_paintFn);
+                                    }));
+    };
+    d_batch.clear();
+    d_clips.clear();
+
+    for (auto i = 0u; i < count;) {
+        auto& command = display[i];
+        auto  base    = command.d_base;
+        auto  adapter = batches ? static_cast<DrawAdapter*>(&recorder) : ptr;
+        auto  clip    = static_cast<const DrawRegion*>(nullptr);
+
+        if (base->d_draw.d_hidden) { // hides its descendants
+            i = command.d_end;
+            continue;                                             // CONTINUE
+        }
+
+        if (d_clipPanels) {
+            clip = enterClip(command, i);
+
+            if (clip && !overlaps(*clip, regionOf(base->d_draw))) {
+                d_drawCounters.d_clipped += 1;
+                i = command.d_end; // so are its descendants
+                continue;                                         // CONTINUE
+            }
+        }
+
+        if (d_cullOccluded && d_occluded[i]) {
+            d_drawCounters.d_culled += 1;
+            i += 1; // a panel's widgets may still be seen
+            continue;                                             // CONTINUE
+        }
+
+        if (partial
+         && std::none_of(d_damage.begin(),
+                         d_damage.end(),
+                         [&command](const DrawRegion& region) {
+                             return overlaps(region, command.d_region);
+                         })) {
+            d_drawCounters.d_skipped += 1;
+            i += 1; // a panel's widgets may still be damaged
+            continue;                                             // CONTINUE
+        }
+        d_drawCounters.d_drawn += 1;
+
+        if (batches && painted(command)) { // paint functions draw directly
+            flush();
+            adapter = ptr;
+        }
+
+        if (d_clipPanels) {
+            adapter->setClip(clip);
+        }
+
+        switch (command.d_code) {
+            case Command::eWIDGET: {
+                base->d_draw.draw(adapter,
+                                  base->d_text.getText(),
+                                  base->d_text.generation());
+            } break;                                                   // BREAK
+            case Command::eBUTTONBAR: {
+                static_cast<const ButtonBar*>(base)->draw(adapter, clip);
+            } break;                                                   // BREAK
+            case Command::eLIST: {
+                static_cast<const List*>(base)->draw(adapter, clip);
+            } break;                                                   // BREAK
+            case Command::eTEXTEDITOR: {
+                static_cast<const TextEditor*>(base)->draw(adapter);
+            } break;                                                   // BREAK
+        }
+
+        if (d_clipPanels && batches && adapter == ptr) {
+            ptr->setClip(nullptr); // the batches start unclipped
+        }
+        i += 1;
+    }
+    flush();
+
+    if (d_clipPanels && !batches) {
+        ptr->setClip(nullptr);
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::addDamage(const DrawRegion& region)
+{
+    auto merged = region;
+
+    // Absorb the regions it overlaps; the union may overlap others.
+    for (auto i = 0u; i < d_damage.size();) {
+        if (overlaps(d_damage[i], merged)) {
+            unite(&merged, d_damage[i]);
+            d_damage[i] = d_damage.back();
+            d_damage.pop_back();
+            i = 0;
+        }
+        else {
+            i += 1;
+        }
+    }
+    d_damage.push_back(merged);
+
+    if (d_damage.size() > kMAX_DAMAGE) {
+        for (auto i = 1u; i < d_damage.size(); ++i) {
+            unite(&d_damage[0], d_damage[i]);
+        }
+        d_damage.resize(1);
+    }
+    return;                                                           // RETURN
+}
+
+bool
+Wawt::collectDamage(const Panel&                              root,
+                    const std::vector<Panel::DisplayCommand>& previous)
+{
+    // The frame is whole if it was of another screen, or the screen was
+    // drawn since by another 'Wawt'.  After a recompile, or once widgets
+    // were moved (e.g. by a layout), each command is compared with the one
+    // last drawn for its widget: the regions of unmatched commands are
+    // damaged, as are both regions of one that moved, was shown or hidden,
+    // was reordered, or no longer draws as it did.  Otherwise only the
+    // widgets marked damaged since the last frame are, with those of their
+    // descendants (e.g. a panel that was hidden), and the painted ones.
+    using Command = Panel::DisplayCommand;
+    auto& index   = root.d_index;
+    auto& display = index.d_display;
+    auto  whole   = d_damageRoot != &root || d_damageFrame != index.d_frames;
+    auto  damaged = index.takeDamaged();
+
+    d_damageRoot  = &root;
+    d_damageFrame = index.d_frames;
+    d_damage.clear();
+
+    if (whole
+     || !previous.empty()
+     || index.d_displayGeometry != index.d_geometry) {
+        auto prior  = std::unordered_map<const Base*, const Command*>();
+        auto hidden = std::size_t(0); // end of a hidden panel's widgets
+
+        for (auto& command : previous) {
+            prior.emplace(command.d_base, &command);
+        }
+
+        for (auto i = 0u; i < display.size(); ++i) {
+            auto& command = display[i];
+            auto& view    = command.d_base->d_draw;
+            auto  before  = static_cast<const Command*>(&command);
+
+            if (i >= hidden && view.d_hidden) {
+                hidden = command.d_end;
+            }
+            auto shown  = i >= hidden;
+            auto region = regionOf(view);
+
+            if (!previous.empty()) {
+                auto it = prior.find(command.d_base);
+                before  = it == prior.end() ? nullptr : it->second;
+
+                if (before) {
+                    prior.erase(it);
+                }
+            }
+
+            if (!whole) {
+                if (!before) {
+                    addDamage(region);
+                }
+                else if (before->d_shown != shown
+                      || !sameRegion(before->d_region, region)
+                      || (!previous.empty()
+                       && std::size_t(before - previous.data()) != i)
+                      || (shown && (view.d_paintFn
+                                 || displayChanged(command)))) {
+                    addDamage(before->d_region);
+                    addDamage(region);
+                }
+            }
+            command.d_shown  = shown;
+            command.d_region = region;
+        }
+
+        for (auto& entry : prior) { // no longer drawn
+            addDamage(entry.second->d_region);
+        }
+        index.d_displayGeometry = index.d_geometry;
+    }
+    else {
+        for (auto i : index.d_painted) {
+            if (!display[i].d_base->d_draw.d_hidden) {
+                addDamage(display[i].d_region);
+            }
+        }
+    }
+
+    for (auto slot : damaged) {
+        auto first = slot < index.d_commands.size() ? index.d_commands[slot]
+                                                    : 0;
+
+        if (slot == 0 || first > 0) { // else not displayed
+            for (auto i = first; i < display[first].d_end; ++i) {
+                addDamage(display[i].d_region);
+            }
+        }
+    }
+
+    if (whole) {
+        d_damage.clear();
+    }
+    return whole;                                                     // RETURN
+}
+
+const Wawt::DrawRegion *
+Wawt::enterClip(const Panel::DisplayCommand& command, std::size_t index)
+{
+    // The commands are visited in order, so the panels whose widgets end
+    // before this one are done with.
+    while (!d_clips.empty() && index >= d_clips.back().d_end) {
+        d_clips.pop_back();
+    }
+
+    if (command.d_end > index + 1) { // a panel clips its widgets
+        auto region = regionOf(command.d_base->d_draw);
+
+        if (!d_clips.empty()) {
+            intersect(&region, d_clips.back().d_region);
+        }
+        d_clips.push_back(Clip{region, command.d_end});
+        return d_clips.size() > 1 ? &d_clips[d_clips.size() - 2].d_region
+                                  : nullptr;                          // RETURN
+    }
+    return d_clips.empty() ? nullptr : &d_clips.back().d_region;      // RETURN
+}
+
+void
+Wawt::executeLayout(Panel *root, const Scale& scale)
+{
+    auto& index  = root->d_index;
+    auto  steps  = index.d_layoutSteps.data();
+    auto& groups = index.d_layoutGroups;
+
+    if (!d_layoutPool || groups.size() < 2) {
+        executeSteps(steps, steps + index.d_layoutSteps.size(), scale);
+        return;                                                       // RETURN
+    }
+
+    // Deal the groups out to one task per thread, balancing the number of
+    // steps.  A failure is reported as it would be by a serial layout: the
+    // exception from the earliest failing step is rethrown.
+    using Failure = std::pair<uint32_t, std::exception_ptr>;
+
+    auto share  = index.d_layoutSteps.size() / d_layoutPool->size() + 1;
+    auto failed = std::vector<Failure>();
+    std::mutex guard;
+    auto tasks  = std::vector<std::function<void()>>();
+    auto next   = groups.cbegin();
+
+    while (next != groups.cend()) {
+        auto first = next;
+        auto size  = std::size_t(0);
+
+        do {
+            for (auto& range : *next) {
+                size += range.second - range.first;
+            }
+            ++next;
+        } while (next != groups.cend() && size < share);
+
+        tasks.push_back([=, &failed, &guard]() {
+            for (auto group = first; group != next; ++group) {
+                for (auto& range : *group) {
+                    try {
+                        executeSteps(steps + range.first,
+                                     steps + range.second,
+                                     scale);
+                    }
+                    catch (...) {
+                        std::lock_guard<std::mutex> lock(guard);
+                        failed.emplace_back(range.first,
+                                            std::current_exception());
+                        return;                                       // RETURN
+                    }
+                }
+            }
+        });
+    }
+    d_layoutPool->run(std::move(tasks));
+
+    if (!failed.empty()) {
+        auto earliest = std::min_element(failed.begin(),
+                                         failed.end(),
+                                         [](auto& lhs, auto& rhs) {
+                                             return lhs.first < rhs.first;
+                                         });
+        std::rethrow_exception(earliest->second);                     // THROW
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::executeSteps(const Panel::LayoutStep  *begin,
+                   const Panel::LayoutStep  *end,
+                   const Scale&              scale)
+{
+    using Step = Panel::LayoutStep;
+
+    for (auto it = begin; it != end; ++it) {
+        auto& step = *it;
+        auto  base = step.d_base;
+
+        switch (step.d_code) {
+            case Step::eWIDGET: {
+                setWidgetDefaults(step.d_widget,
+                                  base,
+                                  d_borderDefaults,
+                                  d_optionDefaults);
+                scaleLayout(&base->d_draw, &base->d_layout, scale);
+            } break;                                                   // BREAK
+            case Step::eUPPER: {
+                base->d_draw.d_upperLeft
+                    = makeAbsolute(base->d_layout.d_upperLeft,
+                                   *step.d_reference);
+            } break;                                                   // BREAK
+            case Step::eLOWER: {
+                base->d_draw.d_lowerRight
+                    = makeAbsolute(base->d_layout.d_lowerRight,
+                                   *step.d_reference);
+            } break;                                                   // BREAK
+            case Step::eTIE: {
+                tieCorners(&base->d_draw, base->d_layout.d_tie);
+            } break;                                                   // BREAK
+            case Step::eDONE: {
+                completeWidgetAdapterValues(step.d_widget,
+                                            scale,
+                                            d_borderDefaults,
+                                            d_optionDefaults);
+            } break;                                                   // BREAK
+        }
+    }
+    return;                                                           // RETURN
+}
+
+bool
+Wawt::idle(Panel *root)
+{
+    if (d_resizePolicy.d_mode != ResizePolicy::Mode::eIDLE
+     || !root->d_widgetId.isSet()) {
+        return false;                                                 // RETURN
+    }
+    auto width  = root->d_draw.width();
+    auto height = root->d_draw.height();
+
+    // Nothing to do if never sized, or if the layout is current:
+    if (width == 1 || (width  == root->d_layout.d_lowerRight.d_x + 1
+                    && height == root->d_layout.d_lowerRight.d_y + 1)) {
+        return false;                                                 // RETURN
+    }
+    interpretRootPanel(root);
+    d_resizeCounters.d_deferred += 1;
+    return true;                                                      // RETURN
+}
+
+void
+Wawt::interpretRootPanel(Panel *root)
+{
+    // Interpret the layout at the current size of the root panel.
+    layoutRootPanel(root, root->d_draw.width(), root->d_draw.height());
+    d_fontIdToSize.clear();
+    setTextAndFontValues(root);
+    refreshRootTextMetrics(root);
+    root->d_index.d_positions += 1; // see: 'FlatScreen'
+    root->d_index.d_geometry  += 1;
+    return;                                                           // RETURN
+}
+
+void
+Wawt::layoutRootPanel(Panel *root, double width, double height)
+{
+    auto baseWidth  = root->d_layout.d_lowerRight.d_x + 1;
+    auto baseHeight = root->d_layout.d_lowerRight.d_y + 1;
+
+    root->d_draw.d_upperLeft                = {0, 0};
+    root->d_draw.d_lowerRight.d_x           = width  - 1;
+    root->d_draw.d_lowerRight.d_y           = height - 1;
+    root->d_draw.d_borderThickness          = 0.0;
+    root->d_layout.d_lowerRight.d_x         = width  - 1;
+    root->d_layout.d_lowerRight.d_y         = height - 1;
+    root->d_layout.d_borderThickness        = 0.0;
+
+    Scale scale{ width/baseWidth, height/baseHeight };
+    auto& index = root->d_index;
+
+    if (!index.empty()
+     && (index.d_layoutGeneration == index.d_generation
+      || compileLayout(root))) {
+        executeLayout(root, scale);
+    }
+    else {
+        for (auto& widget : root->d_widgets) {
+            setWidgetAdapterPositions(&widget,
+                                      root,
+                                      *root,
+                                      scale,
+                                      d_borderDefaults,
+                                      d_optionDefaults);
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::markOccluded(const Panel& root)
+{
+    // Find the boxes of the opaque widgets drawn, then walk the display
+    // list from the last command drawn, keeping the boxes seen so far; a
+    // command is occluded if one contains all the pixels it may draw on.
+    // Only the largest boxes are kept, which suffices for e.g. a dialog box
+    // over a screen.
+    auto& display = root.d_index.d_display;
+    auto  hidden  = std::size_t(0); // end of a hidden panel's widgets
+
+    d_occluded.assign(display.size(), false);
+    d_occluders.clear();
+    d_opaque.clear();
+    d_clips.clear();
+
+    for (auto i = 0u; i < display.size(); ++i) {
+        auto& view = display[i].d_base->d_draw;
+
+        if (i >= hidden && view.d_hidden) {
+            hidden = display[i].d_end;
+        }
 
-wchar_t Wawt::s_downArrow = L'v';
-wchar_t Wawt::s_upArrow   = L'^';
-wchar_t Wawt::s_cursor    = L'|';
+        if (i < hidden) {
+            d_occluded[i] = true; // not drawn, so occludes nothing
+            continue;                                             // CONTINUE
+        }
+        auto clip = d_clipPanels ? enterClip(display[i], i) : nullptr;
+
+        if ((view.d_options.has_value() || view.d_style != 0)
+         && d_adapter_p->opaque(view)) {
+            // Only the pixels entirely inside the box are certain to be
+            // painted, and only if it is not clipped.
+            auto box = DrawRegion{{std::ceil(view.d_upperLeft.d_x),
+                                   std::ceil(view.d_upperLeft.d_y)},
+                                  {std::floor(view.d_lowerRight.d_x),
+                                   std::floor(view.d_lowerRight.d_y)}};
+
+            if (!clip || contains(*clip, box)) {
+                d_opaque.push_back(Opaque{i, box});
+            }
+        }
+    }
+    auto next = d_opaque.rbegin();
 
-// PUBLIC CONSTRUCTOR
-Wawt::Wawt(const TextMapper& mappingFn, DrawAdapter *adapter)
-: d_adapter_p(adapter ? adapter : &s_defaultAdapter)
-, d_idToString(mappingFn)
-, d_fontIdToSize()
-, d_borderDefaults()
-{
-}
+    for (auto i = display.size(); i-- > 0;) {
+        auto& view = display[i].d_base->d_draw;
 
-// PUBLIC METHODS
+        if (d_occluded[i]) {
+            continue;                                             // CONTINUE
+        }
+        d_occluded[i] = std::any_of(d_occluders.begin(),
+                                    d_occluders.end(),
+                                    [&view](const DrawRegion& box) {
+                                        return contains(box, regionOf(view));
+                                    });
 
-void
-Wawt::draw(const Panel& panel)
-{
-    auto ptr = d_adapter_p;
+        if (next != d_opaque.rend() && next->d_index == i) {
+            auto& box = next->d_box;
 
-    if (panel.draw(ptr)) {
-        for (auto const& widget : panel.d_widgets) {
-            switch (widget.index()) {
-                case kCANVAS:    std::get<Canvas>(widget).draw(ptr);    break;
-                case kTEXTENTRY: std::get<TextEntry>(widget).draw(ptr); break;
-                case kLABEL:     std::get<Label>(widget).draw(ptr);     break;
-                case kBUTTON:    std::get<Button>(widget).draw(ptr);    break;
-                case kBUTTONBAR: std::get<ButtonBar>(widget).draw(ptr); break;
-                case kLIST:      std::get<List>(widget).draw(ptr);      break;
-                case kPANEL:     draw(std::get<Panel>(widget));         break;
-                default: abort();
+            if (d_occluders.size() < kMAX_OCCLUDERS) {
+                d_occluders.push_back(box);
+            }
+            else {
+                auto smallest = std::min_element(
+                                    d_occluders.begin(),
+                                    d_occluders.end(),
+                                    [](const DrawRegion& a,
+                                       const DrawRegion& b) {
+                                        return area(a) < area(b);
+                                    });
+
+                if (area(*smallest) < area(box)) {
+                    *smallest = box;
+                }
             }
+            ++next;
         }
     }
     return;                                                           // RETURN
@@ -1846,7 +4305,10 @@ Wawt::popUpModalDialogBox(Panel *root, Panel&& dialogBox)
     canvas.d_widgetId          = Wawt_Id::inc(nextId);
     canvas.d_draw.d_upperLeft  = root->d_draw.d_upperLeft;
     canvas.d_draw.d_lowerRight = root->d_draw.d_lowerRight;
-    widgets.emplace_back(canvas);
+    auto& canvasWidget         = widgets.emplace_back(canvas);
+    root->d_index.insert(std::get<Canvas>(canvasWidget).d_widgetId,
+                         &canvasWidget,
+                         &std::get<Canvas>(canvasWidget).adapterView());
 
     Scale scale(1.0, 1.0);
 
@@ -1859,8 +4321,11 @@ Wawt::popUpModalDialogBox(Panel *root, Panel&& dialogBox)
     }
 
     auto& dialog = widgets.emplace_back(std::move(dialogBox));
-    setIds(&dialog, nextId);
+    setIds(&dialog, nextId, root);
     root->d_widgetId = nextId;
+    setDependencies(root, root, &canvasWidget);
+    setDependencies(root, root, &dialog);
+    sortDependencies(root);
 
     setWidgetAdapterPositions(&dialog,
                               root,
@@ -1875,98 +4340,320 @@ Wawt::popUpModalDialogBox(Panel *root, Panel&& dialogBox)
     return;                                                           // RETURN
 }
 
+void
+Wawt::refreshChangedTextMetrics(Panel *root)
+{
+    if (root->d_index.empty()) {
+        refreshTextMetrics(root); // IDs not resolved: changes not tracked
+    }
+    else {
+        refreshChanges(root, root);
+    }
+    return;                                                           // RETURN
+}
+
 void
 Wawt::refreshTextMetrics(Panel *panel)
 {
     for (auto& widget : panel->d_widgets) {
-        switch (widget.index()) {
-            case kCANVAS: { // Canvas
-            } break;                                                   // BREAK
-            case kTEXTENTRY: { // TextEntry
-                auto& entry = std::get<TextEntry>(widget);
-                refreshTextMetric(&entry.d_draw,
-                                  &entry.d_text,
+        refreshTextMetrics(&widget);
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::refreshChanges(Panel *root, Panel *panel)
+{
+    auto changes = std::move(panel->d_link.d_changes);
+    panel->d_link.d_changes.clear();
+
+    for (auto base : changes) {
+        auto widget = root->d_index.d_widgets[base->d_widgetId.value()];
+
+        base->d_link.d_marked = false;
+
+        if (widget->index() == kPANEL) {
+            refreshChanges(root, &std::get<Panel>(*widget));
+        }
+        else {
+            refreshTextMetrics(widget);
+            base->d_link.markDamaged(); // e.g. resized its text
+        }
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::refreshRootTextMetrics(Panel *root)
+{
+    // A font size group whose smallest member measured zero takes the size
+    // its first member is measured at next (see: 'refreshTextMetric'), so
+    // its size depends on the order the members are refreshed in.
+    auto unsized = std::any_of(d_fontIdToSize.begin(),
+                               d_fontIdToSize.end(),
+                               [](const FontIdMap::value_type& entry) {
+                                   return entry.second == 0;
+                               });
+
+    if (!d_layoutPool || !d_adapter_p->threadSafe() || unsized) {
+        refreshTextMetrics(root);
+        return;                                                       // RETURN
+    }
+    // The font size map is shared.  As no group's size is zero, it is only
+    // read here.
+    auto widgets = std::vector<Panel::Widget*>();
+
+    for (auto& widget : root->d_widgets) {
+        widgets.push_back(&widget);
+    }
+    auto count  = std::size_t(d_layoutPool->size());
+    auto share  = (widgets.size() + count - 1) / count;
+    auto failed = std::exception_ptr();
+    std::mutex guard;
+    auto tasks  = std::vector<std::function<void()>>();
+
+    for (auto first = std::size_t(0); first < widgets.size(); first += share) {
+        auto last = std::min(first + share, widgets.size());
+
+        tasks.push_back([=, &widgets, &failed, &guard]() {
+            try {
+                for (auto i = first; i < last; ++i) {
+                    refreshTextMetrics(widgets[i]);
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(guard);
+
+                if (!failed) {
+                    failed = std::current_exception();
+                }
+            }
+        });
+    }
+    d_layoutPool->run(std::move(tasks));
+
+    if (failed) {
+        std::rethrow_exception(failed);                               // THROW
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::refreshTextMetrics(Panel::Widget *widget)
+{
+    switch (widget->index()) {
+        case kCANVAS: { // Canvas
+        } break;                                                       // BREAK
+        case kTEXTENTRY: { // TextEntry
+            auto& entry = std::get<TextEntry>(*widget);
+            refreshTextMetric(&entry.d_draw,
+                              &entry.d_text,
+                              d_adapter_p,
+                              d_fontIdToSize,
+                              &d_textMetricsCache);
+        } break;                                                       // BREAK
+        case kLABEL: { // Label
+            auto& label = std::get<Label>(*widget);
+            refreshTextMetric(&label.d_draw,
+                              &label.d_text,
+                              d_adapter_p,
+                              d_fontIdToSize,
+                              &d_textMetricsCache);
+        } break;                                                       // BREAK
+        case kBUTTON: { // Button
+            auto& button = std::get<Button>(*widget);
+            refreshTextMetric(&button.d_draw,
+                              &button.d_text,
+                              d_adapter_p,
+                              d_fontIdToSize,
+                              &d_textMetricsCache);
+        } break;                                                       // BREAK
+        case kBUTTONBAR: { // ButtonBar
+            auto& bar = std::get<ButtonBar>(*widget);
+
+            if (bar.d_buttons.empty()) {
+                break;                                                 // BREAK
+            }
+            auto count = int(bar.d_buttons.size());
+            std::optional<int> maxWidth;
+
+            for (auto& button : bar.d_buttons) {
+                refreshTextMetric(&button.d_draw,
+                                  &button.d_text,
                                   d_adapter_p,
-                                  d_fontIdToSize);
-            } break;                                                   // BREAK
-            case kLABEL: { // Label
-                auto& label = std::get<Label>(widget);
-                refreshTextMetric(&label.d_draw,
-                                  &label.d_text,
+                                  d_fontIdToSize,
+                                  &d_textMetricsCache);
+                auto width = button.d_text.d_metrics.d_textWidth
+                                + 2*button.d_draw.d_borderThickness + 4;
+
+                if (!maxWidth.has_value() || maxWidth.value() < width) {
+                    maxWidth = width;
+                }
+            }
+            auto barWidth = bar.d_draw.interiorWidth();
+            auto spacing = count == 1
+                ? 0
+                : (barWidth - count*maxWidth.value())/(count - 1);
+
+            if (spacing > maxWidth.value()/2) {
+                spacing = maxWidth.value()/2;
+            }
+            auto margin = (barWidth - count * maxWidth.value()
+                                    - (count-1) * spacing)/2;
+            auto startx = bar.d_draw.d_upperLeft.d_x + margin;
+
+            for (auto& button : bar.d_buttons) {
+                auto& view  = button.d_draw;
+                view.d_upperLeft.d_x  = startx;
+                view.d_lowerRight.d_x = startx + maxWidth.value();
+                startx += maxWidth.value() + spacing;
+                refreshTextMetric(&view,
+                                  &button.d_text,
                                   d_adapter_p,
-                                  d_fontIdToSize);
-            } break;                                                   // BREAK
-            case kBUTTON: { // Button
-                auto& button = std::get<Button>(widget);
+                                  d_fontIdToSize,
+                                  &d_textMetricsCache);
+            }
+        } break;                                                       // BREAK
+        case kLIST: { // List
+            auto& list = std::get<List>(*widget);
+            for (auto& button : list.d_buttons) {
                 refreshTextMetric(&button.d_draw,
                                   &button.d_text,
                                   d_adapter_p,
-                                  d_fontIdToSize);
-            } break;                                                   // BREAK
-            case kBUTTONBAR: { // ButtonBar
-                auto& bar = std::get<ButtonBar>(widget);
+                                  d_fontIdToSize,
+                                  &d_textMetricsCache);
+            }
+        } break;                                                       // BREAK
+        case kPANEL: { // Panel
+            refreshTextMetrics(&std::get<Panel>(*widget));
+        } break;                                                       // BREAK
+        case kTEXTEDITOR: { // TextEditor
+            // All rows share the character size that fits the first.
+            auto&         editor = std::get<TextEditor>(*widget);
+            DrawDirective row(std::any(editor.d_draw.d_options));
+            TextBlock     sample(TextString(std::wstring(L"Mg")));
+
+            editor.rowView(&row, 0);
+
+            sample.initTextMetricValues(&row,
+                                        d_adapter_p,
+                                        0,
+                                        &d_textMetricsCache);
+            editor.d_draw.d_charSize = row.d_charSize;
+        } break;                                                       // BREAK
+        default: abort();
+    }
+    return;                                                           // RETURN
+}
 
-                if (bar.d_buttons.empty()) {
-                    break;                                             // BREAK
-                }
-                auto count = int(bar.d_buttons.size());
-                std::optional<int> maxWidth;
-
-                for (auto& button : bar.d_buttons) {
-                    refreshTextMetric(&button.d_draw,
-                                      &button.d_text,
-                                      d_adapter_p,
-                                      d_fontIdToSize);
-                    auto width = button.d_text.d_metrics.d_textWidth
-                                    + 2*button.d_draw.d_borderThickness + 4;
-
-                    if (!maxWidth.has_value() || maxWidth.value() < width) {
-                        maxWidth = width;
-                    }
-                }
-                auto barWidth = bar.d_draw.interiorWidth();
-                auto spacing = count == 1
-                    ? 0
-                    : (barWidth - count*maxWidth.value())/(count - 1);
+void
+Wawt::relayout(Panel *root, WidgetId id)
+{
+    auto& index = root->d_index;
 
-                if (spacing > maxWidth.value()/2) {
-                    spacing = maxWidth.value()/2;
-                }
-                auto margin = (barWidth - count * maxWidth.value()
-                                        - (count-1) * spacing)/2;
-                auto startx = bar.d_draw.d_upperLeft.d_x + margin;
-
-                for (auto& button : bar.d_buttons) {
-                    auto& view  = button.d_draw;
-                    view.d_upperLeft.d_x  = startx;
-                    view.d_lowerRight.d_x = startx + maxWidth.value();
-                    startx += maxWidth.value() + spacing;
-                    refreshTextMetric(&view,
-                                      &button.d_text,
-                                      d_adapter_p,
-                                      d_fontIdToSize);
-                }
-            } break;                                                   // BREAK
-            case kLIST: { // List
-                auto& list = std::get<List>(widget);
-                for (auto& button : list.d_buttons) {
-                    refreshTextMetric(&button.d_draw,
-                                      &button.d_text,
-                                      d_adapter_p,
-                                      d_fontIdToSize);
-                }
-            } break;                                                   // BREAK
-            case kPANEL: { // Panel
-                refreshTextMetrics(&std::get<Panel>(widget));
-            } break;                                                   // BREAK
-            default: abort();
+    if (!root->d_widgetId.isSet() || index.empty()) {
+        throw Exception("Root 'Panel' widget IDs not resolved.");      // THROW
+    }
+    auto width  = root->d_draw.width();
+    auto height = root->d_draw.height();
+
+    if (width == 1) {
+        throw Exception("Root 'Panel' has not been sized.");          // THROW
+    }
+
+    if (width  != root->d_layout.d_lowerRight.d_x + 1
+     || height != root->d_layout.d_lowerRight.d_y + 1) {
+        // The screen was rescaled after the layout was last interpreted so
+        // the layout offsets do not match the current positions.  Catch up
+        // with a full pass; subsequent calls are incremental.
+        interpretRootPanel(root);
+        return;                                                       // RETURN
+    }
+    std::size_t start = 0;
+
+    if (id != root->d_widgetId && id != kROOT) {
+        if (id.isRelative()
+         || id.value() >= index.d_widgets.size()
+         || !index.d_widgets[id.value()]) {
+            throw Exception("Relayout widget not found.", id);        // THROW
+        }
+        start = id.value();
+
+        if (relinkLayout(root, start)) {
+            compileLayout(root);
+        }
+    }
+    std::vector<bool>     visited(index.d_widgets.size(), false);
+    std::vector<uint16_t> affected{uint16_t(start)};
+
+    visited[start] = true;
+
+    for (auto i = 0u; i < affected.size(); ++i) {
+        for (auto dependent : index.d_dependents[affected[i]]) {
+            if (!visited[dependent]) {
+                visited[dependent] = true;
+                affected.push_back(dependent);
+            }
+        }
+    }
+    std::sort(affected.begin(), affected.end(),
+              [&index](auto lhs, auto rhs) {
+                  return index.d_ranks[lhs] < index.d_ranks[rhs];
+              });
+
+    // The layout is current, so it is not rescaled (scale is one).
+    Scale scale{1.0, 1.0};
+    bool  fontGroups = false;
+
+    for (auto slot : affected) {
+        if (slot == 0) { // the root panel is sized by 'resizeRootPanel'
+            continue;                                             // CONTINUE
+        }
+        auto widget = index.d_widgets[slot];
+        auto parent = index.d_parents[slot];
+        setWidgetAdapterValues(widget,
+                               root,
+                               parent ? *parent : *root,
+                               scale,
+                               d_borderDefaults,
+                               d_optionDefaults);
+        fontGroups = fontGroups || hasFontSizeGroup(*widget);
+    }
+
+    if (fontGroups) { // a group's font size may have changed
+        // Refreshing text metrics narrows the buttons of a 'ButtonBar', so
+        // the remaining bars are re-sliced before all text is refreshed.
+        for (auto slot = 1u; slot < index.d_widgets.size(); ++slot) {
+            auto widget = index.d_widgets[slot];
+
+            if (!visited[slot] && widget && widget->index() == kBUTTONBAR) {
+                auto parent = index.d_parents[slot];
+                setWidgetAdapterValues(widget,
+                                       root,
+                                       parent ? *parent : *root,
+                                       scale,
+                                       d_borderDefaults,
+                                       d_optionDefaults);
+            }
         }
+        d_fontIdToSize.clear();
+        setTextAndFontValues(root);
+        refreshRootTextMetrics(root);
     }
+    else {
+        for (auto slot : affected) {
+            if (slot != 0 && index.d_widgets[slot]->index() != kPANEL) {
+                refreshTextMetrics(index.d_widgets[slot]);
+            }
+        }
+    }
+    index.d_positions += 1; // see: 'FlatScreen'
+    index.d_geometry  += 1;
     return;                                                           // RETURN
 }
 
 void
-Wawt::resizeRootPanel(Panel *root, double width, double  height)
+Wawt::resize(Panel *root, double width, double height, FlatScreen *compiled)
 {
     if (!root->d_widgetId.isSet()) {
         throw Exception("Root 'Panel' widget IDs not resolved.");      // THROW
@@ -1985,35 +4672,45 @@ Wawt::resizeRootPanel(Panel *root, double width, double  height)
             Exception("Root 'Panel' lower right offsets are bad (not set?).");
     }
 
-    if (!root->drawView().options().has_value()) {
-         root->drawView().options() = d_optionDefaults.d_screenOptions;
+    if (!root->adapterView().d_options.has_value()
+     && root->adapterView().d_style == 0) {
+        if (d_optionDefaults.d_screenStyle != 0) {
+            root->drawView().style()   = d_optionDefaults.d_screenStyle;
+        }
+        else {
+            root->drawView().options() = d_optionDefaults.d_screenOptions;
+        }
+    }
+    // Optimization: instead of interpreting the layout on each call, the
+    // current positions can be rescaled (improves drag resizing
+    // performance).  The policy decides when the error is too large.
+    bool interpretLayout = root->d_draw.width() == 1;
+
+    if (!interpretLayout) {
+        auto& policy = d_resizePolicy;
+
+        switch (policy.d_mode) {
+            case ResizePolicy::Mode::eRATIO: {
+                interpretLayout
+                    = std::abs(width-baseWidth)/baseWidth    > policy.d_ratio
+                   || std::abs(height-baseHeight)/baseHeight > policy.d_ratio;
+            } break;
+            case ResizePolicy::Mode::eINTERPRET: {
+                interpretLayout = true;
+            } break;
+            case ResizePolicy::Mode::eDRIFT: {
+                interpretLayout
+                    = std::abs(width-baseWidth)   > policy.d_maxDrift
+                   || std::abs(height-baseHeight) > policy.d_maxDrift;
+            } break;
+            case ResizePolicy::Mode::eIDLE: { // see: 'idle'
+            } break;
+        }
     }
-    // Optimization: instead of interpreting the layout on each call, do it
-    // when the new size is about 25% larger than the old size (improves
-    // drag resizing performance).
-    bool interpretLayout = root->d_draw.width() == 1
-                        || std::abs(width-baseWidth)/baseWidth    > 0.25
-                        || std::abs(height-baseHeight)/baseHeight > 0.25;
 
     if (interpretLayout) {
-        root->d_draw.d_upperLeft                = {0, 0};
-        root->d_draw.d_lowerRight.d_x           = width  - 1;
-        root->d_draw.d_lowerRight.d_y           = height - 1;
-        root->d_draw.d_borderThickness          = 0.0;
-        root->d_layout.d_lowerRight.d_x         = width  - 1;
-        root->d_layout.d_lowerRight.d_y         = height - 1;
-        root->d_layout.d_borderThickness        = 0.0;
-
-        Scale scale{ width/baseWidth, height/baseHeight };
-
-        for (auto& widget : root->d_widgets) {
-            setWidgetAdapterPositions(&widget,
-                                      root,
-                                      *root,
-                                      scale,
-                                      d_borderDefaults,
-                                      d_optionDefaults);
-        }
+        layoutRootPanel(root, width, height);
+        d_resizeCounters.d_interpreted += 1;
     }
     auto  sizex  = root->d_draw.width();
     auto  sizey  = root->d_draw.height();
@@ -2028,13 +4725,38 @@ Wawt::resizeRootPanel(Panel *root, double width, double  height)
         auto borderScale = std::min(width/(root->d_layout.d_lowerRight.d_x+1),
                                     height/(root->d_layout.d_lowerRight.d_y+1));
 
-        for (auto& nextWidget : root->d_widgets) {
-            scalePosition(&nextWidget, scale, borderScale);
+        if (compiled) {
+            rescaleCompiled(compiled, scale, borderScale);
         }
+        else {
+            for (auto& nextWidget : root->d_widgets) {
+                scalePosition(&nextWidget, scale, borderScale);
+            }
+        }
+        d_resizeCounters.d_rescaled += 1;
     }
     d_fontIdToSize.clear();
     setTextAndFontValues(root);
-    refreshTextMetrics(root);
+    refreshRootTextMetrics(root);
+    root->d_index.d_geometry += 1;
+    return;                                                           // RETURN
+}
+
+void
+Wawt::resizeRootPanel(Panel *root, double width, double  height)
+{
+    resize(root, width, height, nullptr);
+    return;                                                           // RETURN
+}
+
+void
+Wawt::resizeRootPanel(FlatScreen *compiled, double width, double height)
+{
+    if (!isCurrent(*compiled)) {
+        compileScreen(compiled, compiled->d_root);
+    }
+    resize(compiled->d_root, width, height, compiled);
+    captureGeometry(compiled);
     return;                                                           // RETURN
 }
 
@@ -2043,11 +4765,168 @@ Wawt::resolveWidgetIds(Panel *root)
 {
     WidgetId nextId = 1_w;
 
+    root->d_index.clear();
+
     for (auto& widget : root->d_widgets) {
-        setIds(&widget, nextId);
+        setIds(&widget, nextId, root);
     }
     root->d_widgetId        = nextId;
     root->d_draw.d_tracking = std::make_tuple(kPANEL, nextId.value(), -1);
+    root->d_link.d_widget   = root;
+
+    for (auto& widget : root->d_widgets) {
+        setDependencies(root, root, &widget);
+    }
+    sortDependencies(root);
+    compileLayout(root);
+    return;                                                           // RETURN
+}
+
+bool
+Wawt::restoreLayout(Panel *root, const LayoutSnapshot& snapshot)
+{
+    if (snapshot.d_root != root
+     || snapshot.d_generation != root->d_index.d_generation
+     || snapshot.d_positions  != root->d_index.d_positions) {
+        return false;                                                 // RETURN
+    }
+    std::vector<Base*> bases{root};
+    std::vector<List*> lists;
+    bases.reserve(snapshot.d_entries.size());
+    collectBases(root, &bases, &lists);
+
+    if (bases.size() != snapshot.d_entries.size()
+     || lists.size() != snapshot.d_lists.size()) {
+        return false;                                                 // RETURN
+    }
+
+    // Text is mapped as 'setTextAndFontValues' would, so that a change to
+    // the 'TextId' mapping is detected below.
+    for (auto i = 0u; i < bases.size(); ++i) {
+        auto  base  = bases[i];
+        auto& entry = snapshot.d_entries[i];
+
+        if (std::get<0>(base->d_draw.d_tracking) != kTEXTENTRY) {
+            base->d_text.setText(&d_textTable);
+        }
+        auto& text = base->d_text.d_block;
+
+        if (base->d_draw.d_hidden != entry.d_hidden
+         || text.d_id             != entry.d_text.d_id
+         || text.d_alignment      != entry.d_text.d_alignment
+         || text.d_fontSizeGrp    != entry.d_text.d_fontSizeGrp
+         || text.d_string         != entry.d_text.d_string) {
+            return false;                                             // RETURN
+        }
+    }
+
+    for (auto i = 0u; i < lists.size(); ++i) {
+        if (lists[i]->d_startRow != snapshot.d_lists[i].d_startRow) {
+            return false;                                             // RETURN
+        }
+    }
+
+    for (auto i = 0u; i < bases.size(); ++i) {
+        auto  base  = bases[i];
+        auto& entry = snapshot.d_entries[i];
+        auto& view  = base->d_draw;
+        view.d_upperLeft                 = entry.d_upperLeft;
+        view.d_lowerRight                = entry.d_lowerRight;
+        view.d_borderThickness           = entry.d_borderThickness;
+        view.d_startx                    = entry.d_startx;
+        view.d_charSize                  = entry.d_charSize;
+        base->d_layout.d_borderThickness = entry.d_layoutBorder;
+        base->d_text.d_metrics           = entry.d_metrics;
+    }
+
+    for (auto i = 0u; i < lists.size(); ++i) {
+        lists[i]->d_rowHeight = snapshot.d_lists[i].d_rowHeight;
+        lists[i]->d_rows      = snapshot.d_lists[i].d_rows;
+    }
+    root->d_layout.d_lowerRight.d_x = snapshot.d_layoutSize.d_x;
+    root->d_layout.d_lowerRight.d_y = snapshot.d_layoutSize.d_y;
+    root->d_index.d_geometry       += 1;
+    d_fontIdToSize                  = snapshot.d_fontIdToSize;
+    return true;                                                      // RETURN
+}
+
+bool
+Wawt::restoreLayout(FlatScreen *compiled, const LayoutSnapshot& snapshot)
+{
+    if (!isCurrent(*compiled)) {
+        compileScreen(compiled, compiled->d_root);
+    }
+
+    if (!restoreLayout(compiled->d_root, snapshot)) {
+        return false;                                                 // RETURN
+    }
+    captureGeometry(compiled);
+    return true;                                                      // RETURN
+}
+
+unsigned int
+Wawt::layoutThreads() const
+{
+    return d_layoutPool ? d_layoutPool->size() : 1;                  // RETURN
+}
+
+void
+Wawt::saveLayout(LayoutSnapshot *snapshot, Panel *root) const
+{
+    std::vector<Base*> bases{root};
+    std::vector<List*> lists;
+    collectBases(root, &bases, &lists);
+
+    snapshot->clear();
+    snapshot->d_root           = root;
+    snapshot->d_generation     = root->d_index.d_generation;
+    snapshot->d_positions      = root->d_index.d_positions;
+    snapshot->d_layoutSize.d_x = root->d_layout.d_lowerRight.d_x;
+    snapshot->d_layoutSize.d_y = root->d_layout.d_lowerRight.d_y;
+    snapshot->d_fontIdToSize   = d_fontIdToSize;
+    snapshot->d_entries.reserve(bases.size());
+    snapshot->d_lists.reserve(lists.size());
+
+    for (auto base : bases) {
+        auto& view = base->d_draw;
+        snapshot->d_entries.push_back({ view.d_upperLeft,
+                                        view.d_lowerRight,
+                                        view.d_borderThickness,
+                                        base->d_layout.d_borderThickness,
+                                        view.d_startx,
+                                        view.d_charSize,
+                                        view.d_hidden,
+                                        base->d_text.d_metrics,
+                                        base->d_text.d_block });
+    }
+
+    for (auto list : lists) {
+        snapshot->d_lists.push_back({ list->d_rowHeight,
+                                      list->d_rows,
+                                      list->d_startRow });
+    }
+    return;                                                           // RETURN
+}
+
+void
+Wawt::setStyleTable(std::shared_ptr<const StyleTable> styles)
+{
+    d_styleTable = std::move(styles);
+    d_adapter_p->setStyleTable(d_styleTable);
+    d_damageRoot = nullptr; // every style may look different
+    return;                                                           // RETURN
+}
+
+void
+Wawt::setLayoutThreads(unsigned int threads)
+{
+    if (threads < 2) {
+        d_layoutPool.reset();
+    }
+    else if (!d_layoutPool || d_layoutPool->size() != threads) {
+        d_layoutPool.reset(); // join the old threads first
+        d_layoutPool = std::make_unique<ThreadPool>(threads);
+    }
     return;                                                           // RETURN
 }
 
@@ -2060,7 +4939,8 @@ Wawt::setFontSizeEntry(Base *base)
         FontIdMap::iterator it = d_fontIdToSize.insert({id, 0}).first;
         base->textView().initTextMetricValues(&base->d_draw,
                                               d_adapter_p,
-                                              it->second);
+                                              it->second,
+                                              &d_textMetricsCache);
         auto charSize = base->d_draw.d_charSize;
 
         if (it->second == 0 || it->second > charSize) {
@@ -2083,17 +4963,17 @@ Wawt::setTextAndFontValues(Panel *root)
                 } break;
             case kLABEL: {
                     auto& label = std::get<Label>(widget);
-                    label.textView().setText(d_idToString);
+                    label.textView().setText(&d_textTable);
                     setFontSizeEntry(&label);
                 } break;
             case kBUTTON: {
                     auto& btn = std::get<Button>(widget);
-                    btn.textView().setText(d_idToString);
+                    btn.textView().setText(&d_textTable);
                     setFontSizeEntry(&btn);
                 } break;
             case kBUTTONBAR: {
                     for (auto& btn : std::get<ButtonBar>(widget).d_buttons) {
-                        btn.textView().setText(d_idToString);
+                        btn.textView().setText(&d_textTable);
                         setFontSizeEntry(&btn);
                     }
                 } break;
@@ -2101,13 +4981,15 @@ Wawt::setTextAndFontValues(Panel *root)
                     auto& list = std::get<List>(widget);
 
                     for (auto& btn : list.d_buttons) {
-                        btn.textView().setText(d_idToString);
+                        btn.textView().setText(&d_textTable);
                         setFontSizeEntry(&btn);
                     }
                 } break;
             case kPANEL: {
                     setTextAndFontValues(&std::get<Panel>(widget));
                 } break;
+            case kTEXTEDITOR: {
+                } break;
             default: abort();
         }
     }
@@ -2131,8 +5013,12 @@ WawtDump::draw(const Wawt::DrawDirective&  widget,
     }
     d_dumpOs  << L"' borderThickness='"    << widget.d_borderThickness
               << L"' greyEffect='"         << widget.d_greyEffect
-              << L"' options='"            << widget.d_options.has_value()
-              << L"'>\n";
+              << L"' options='"            << widget.d_options.has_value();
+
+    if (widget.d_style != 0) {
+        d_dumpOs  << L"' style='"          << widget.d_style;
+    }
+    d_dumpOs  << L"'>\n";
     d_indent += 2;
     d_dumpOs  << d_indent
               << L"<UpperLeft x='"         << widget.d_upperLeft.d_x
@@ -2149,6 +5035,10 @@ WawtDump::draw(const Wawt::DrawDirective&  widget,
                   << L"<Text startx='"     << Int(widget.d_startx)
                   << L"' selected='"       << widget.d_selected;
 
+        if (widget.d_cursor >= 0) {
+            d_dumpOs  << L"' cursor='"     << widget.d_cursor;
+        }
+
         if (widget.d_bulletType      == Wawt::BulletType::eCHECK) {
             d_dumpOs  << L"' bulletType='Check";
         }
@@ -22,17 +22,22 @@
 #include <any>
 #include <cassert>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -193,6 +198,7 @@ class Wawt {
     class  List;
     class  Canvas;
     class  Text;
+    class  TextMetricsCache;
     class  Panel;
 
     // PUBLIC TYPES
@@ -219,11 +225,40 @@ class Wawt {
 
     using PaintFn     = std::function<void(int ux, int uy, int lx, int ly)>;
 
+    using StyleId     = uint16_t; // in the 'StyleTable', or 0 if none
+
     struct  DrawPosition  {
         double              d_x               = 0.0;
         double              d_y               = 0.0;
     };
 
+    struct  DrawRegion {    // e.g. damaged by a change (see: 'DrawAdapter')
+        DrawPosition        d_upperLeft       {};
+        DrawPosition        d_lowerRight      {};
+    };
+
+    struct  DrawState {     // what a directive was last drawn with
+        DrawPosition        d_upperLeft       {};
+        DrawPosition        d_lowerRight      {};
+        double              d_borderThickness = 0.0;
+        double              d_startx          = 0.0;
+        std::size_t         d_text            = 0; // the text's generation
+        unsigned int        d_charSize        = 0u;
+        int                 d_cursor          = -1;
+        StyleId             d_style           = 0;
+        BulletType          d_bulletType      = BulletType::eNONE;
+        bool                d_greyEffect      = false;
+        bool                d_selected        = false;
+        bool                d_hasOptions      = false;
+    };
+
+    struct  DrawCache {     // an adapter's objects kept between frames
+        std::any            d_objects;          // owned by the adapter
+        std::size_t         d_built           = 0; // 'd_generation' of
+        std::size_t         d_generation      = 1; // bumped when changed
+        DrawState           d_drawn           {};
+    };
+
     struct DrawDirective {
         using Tracking = std::tuple<int,int,int>;
         Tracking            d_tracking; // handy debug info
@@ -236,12 +271,36 @@ class Wawt {
         bool                d_selected        = false;
         double              d_startx          = 0.0; // for text placement
         unsigned int        d_charSize        = 0u; // in pixels
+        int                 d_cursor          = -1; // caret index, or -1
+        StyleId             d_style           = 0; // used over 'd_options'
         std::any            d_options; // default: transparent box, black text
+        mutable DrawCache   d_cache           {}; // see: 'cache'
 
         DrawDirective() : d_tracking{-1,-1,-1} { }
 
         DrawDirective(std::any&& options) : d_options(std::move(options)) { }
 
+        // Return the 'Cached' objects an adapter keeps to draw this
+        // directive, creating them if there are none.  Set 'rebuild' if
+        // they are new, or the directive's geometry, text, char size,
+        // selection, or options changed since they were last returned.
+        template<class Cached>
+        Cached& cache(bool *rebuild) const {
+            auto objects = std::any_cast<Cached>(&d_cache.d_objects);
+
+            *rebuild = !objects || d_cache.d_built != d_cache.d_generation;
+
+            if (!objects) {
+                objects = &d_cache.d_objects.emplace<Cached>();
+            }
+            d_cache.d_built = d_cache.d_generation;
+            return *objects;
+        }
+
+        std::size_t generation() const {
+            return d_cache.d_generation;
+        }
+
         double height() const {
             return d_lowerRight.d_y - d_upperLeft.d_y + 1;
         }
@@ -272,7 +331,10 @@ class Wawt {
         bool                d_hidden;
         PaintFn             d_paintFn;
 
-        bool draw(DrawAdapter *adapter, const std::wstring& text) const;
+        // 'textGeneration' changes whenever 'text' does.
+        bool draw(DrawAdapter         *adapter,
+                  const std::wstring&  text,
+                  std::size_t          textGeneration) const;
 
       public:
         DrawOptions() : DrawDirective() , d_hidden(false) , d_paintFn() { }
@@ -293,18 +355,35 @@ class Wawt {
             return std::move(*this);
         }
 
+        DrawOptions&& style(StyleId value) && {
+            d_style = value;
+            return std::move(*this);
+        }
+
         BulletType& bulletType() {
             return d_bulletType;
         }
 
+        // Only for changing the options: they are assumed to be changed,
+        // so what an adapter cached for them is rebuilt (read them through
+        // a 'const' reference).
         std::any& options() {
+            d_cache.d_generation += 1; // the options may be changed
             return d_options;
         }
 
+        int& cursor() {
+            return d_cursor;
+        }
+
         bool& selected() {
             return d_selected;
         }
 
+        StyleId& style() {
+            return d_style;
+        }
+
         const DrawDirective& adapterView() const {
             return static_cast<const DrawDirective&>(*this);
         }
@@ -313,6 +392,10 @@ class Wawt {
             return d_bulletType;
         }
 
+        int cursor() const {
+            return d_cursor;
+        }
+
         bool hidden() const {
             return d_hidden;
         }
@@ -324,6 +407,10 @@ class Wawt {
         bool selected() const {
             return d_selected;
         }
+
+        StyleId style() const {
+            return d_style;
+        }
     };
 
                                 //===================
@@ -528,6 +615,40 @@ class Wawt {
         double          d_textHeight          = 0;
     };
 
+    // The strings a 'TextMapper' returns, indexed by 'TextId'.  Each ID is
+    // mapped once per generation; 'setMapper' starts a new generation by
+    // remapping every ID seen so far in a single pass.  A 'TextBlock'
+    // already holding the current generation's string is not remapped.
+    class  TextTable {
+        // PRIVATE DATA MEMBERS
+        TextMapper                  d_mapper{};
+        std::vector<std::wstring>   d_strings{};
+        std::vector<bool>           d_mapped{};
+        uint32_t                    d_generation = 1;
+
+      public:
+        // PUBLIC CONSTRUCTORS
+        TextTable()                                 = default;
+
+        explicit TextTable(const TextMapper& mapper) : d_mapper(mapper) { }
+
+        // PUBLIC MANIPULATORS
+
+        // Return the string for 'id', or 'nullptr' if there is no mapper.
+        const std::wstring *lookup(TextId id);
+
+        void setMapper(const TextMapper& mapper);
+
+        // PUBLIC ACCESSORS
+        uint32_t generation()                       const {
+            return d_generation;
+        }
+
+        const TextMapper& mapper()                  const {
+            return d_mapper;
+        }
+    };
+
     struct TextString {
         TextId              d_id;
         std::wstring        d_string;
@@ -576,6 +697,35 @@ class Wawt {
         }
     };
 
+    // A widget's place in a resolved widget tree, used to record which
+    // widgets changed since the last 'Wawt::refreshChangedTextMetrics'.  A
+    // change marks the widget in its panel's change list, and the panel in
+    // its parent's, up to the root.  The link is set when widget IDs are
+    // resolved and, describing a position rather than a value, is neither
+    // copied nor assigned with the widget.  The widget is also marked as
+    // damaged in the root panel's index, so a retained frame is redrawn
+    // where it is (see: 'DrawAdapter::damage'); assigning over a widget
+    // marks it too.
+    struct  TreeLink {
+        Base                   *d_widget = nullptr; // widget to mark
+        Panel                  *d_parent = nullptr; // panel holding it
+        bool                    d_marked = false;   // in parent's changes
+        std::vector<Base*>      d_changes{};        // marked children
+
+        TreeLink()                                  = default;
+
+        TreeLink(const TreeLink&) : TreeLink() { }
+
+        TreeLink& operator=(const TreeLink&) {
+            markDamaged();
+            return *this;
+        }
+
+        void markChanged();
+
+        void markDamaged();
+    };
+
     class TextBlock {
         friend class Base;
         friend class Wawt;
@@ -583,11 +733,16 @@ class Wawt {
 
         TextMetrics         d_metrics       {};
         TextString          d_block         {};
+        TreeLink            d_link          {}; // only 'd_widget' is used
+        uint32_t            d_mapped        {}; // 'TextTable' generation
+        std::size_t         d_generation    {}; // bumped when text changes
 
       public:
         TextBlock()                         = default; 
 
-        TextBlock(const TextString& value) : d_metrics(), d_block(value) { }
+        TextBlock(const TextString& value)
+            : d_metrics(), d_block(value), d_link(), d_mapped()
+            , d_generation() { }
 
         Align& alignment() {
             return d_block.d_alignment;
@@ -599,7 +754,8 @@ class Wawt {
 
         void initTextMetricValues(DrawDirective      *args,
                                   DrawAdapter        *adapter,
-                                  uint16_t            upperLimit = 0);
+                                  uint16_t            upperLimit = 0,
+                                  TextMetricsCache   *cache      = nullptr);
 
         void setText(TextId id);
 
@@ -607,8 +763,18 @@ class Wawt {
 
         void setText(const TextMapper& mappingFn);
 
+        void setText(TextTable *table);
+
+        // Edit the text in place (e.g. at a 'TextEntry' caret).
+        void eraseText(std::size_t position, std::size_t count = 1);
+
+        void insertText(std::size_t position, wchar_t character);
+
         void setText(const TextString& value) {
-            d_block = value;
+            d_block       = value;
+            d_mapped      = 0;
+            d_generation += 1;
+            d_link.markChanged();
         }
 
         Align alignment() const {
@@ -619,6 +785,10 @@ class Wawt {
             return d_block.d_fontSizeGrp;
         }
 
+        std::size_t generation() const {
+            return d_generation;
+        }
+
         const std::wstring& getText() const {
             return d_block.d_string;
         }
@@ -652,6 +822,7 @@ class Wawt {
         InputHandler        d_input{};
         TextBlock           d_text{};
         DrawOptions         d_draw{};
+        TreeLink            d_link{};
 
       public:
         WidgetId            d_widgetId{};
@@ -666,14 +837,18 @@ class Wawt {
             : d_layout(std::move(layout))
             , d_input(std::move(input))
             , d_text(std::move(text))
-            , d_draw(std::move(options)) { }
+            , d_draw(std::move(options))
+            , d_link() { }
 
         // PUBLIC MANIPULATORS
         EventUpCb downEvent(int x, int y) { // overriden in Text
             return d_input.downEvent(x, y, this);
         }
 
+        // The widget is assumed to be changed through the reference (see:
+        // 'TreeLink::markDamaged'), so do not keep it past the next frame.
         DrawOptions& drawView() {
+            d_link.markDamaged();
             return d_draw;
         }
 
@@ -697,7 +872,9 @@ class Wawt {
         }
 
         bool draw(DrawAdapter *adapter)    const {
-            return d_draw.draw(adapter, d_text.getText());
+            return d_draw.draw(adapter,
+                               d_text.getText(),
+                               d_text.generation());
         }
 
         const DrawOptions&    drawView()   const {
@@ -851,7 +1028,9 @@ class Wawt {
     class  ButtonBar final : public Base {
         friend class Wawt;
 
-        void draw(DrawAdapter *adapter) const;
+        // Draw the bar, and its buttons clipped to its box and 'clip'.
+        void draw(DrawAdapter *adapter, const DrawRegion *clip = nullptr)
+                                                                    const;
 
       public:
         std::vector<Button>        d_buttons;
@@ -893,7 +1072,9 @@ class Wawt {
 
         void   initButton(unsigned int index, bool finalButton);
 
-        void   draw(DrawAdapter *adapter) const;
+        // Draw the list, and its rows clipped to its box and 'clip'.
+        void   draw(DrawAdapter           *adapter,
+                    const DrawRegion      *clip = nullptr) const;
 
       public:
         // PUBLIC TYPES
@@ -996,6 +1177,111 @@ class Wawt {
         }
     };
 
+                                    //=================
+                                    // class TextEditor
+                                    //=================
+
+    // A multi-line text field for long documents (e.g. notes or a log).  The
+    // document is a piece table: the original text, an append-only buffer
+    // of inserted text, and a sequence of pieces each selecting a span of
+    // one of them, so an edit never moves the document's characters.  An
+    // index of line start offsets locates lines; only the 'windowSize()'
+    // lines from 'topLine()' are extracted from the pieces (when they
+    // change) and drawn.  Lines are not wrapped.  While the editor has the
+    // focus, characters are inserted at the caret: '\r' starts a new line
+    // and '\b' erases the preceding character.  Editing does not change
+    // the text metrics, so there is no need to refresh them.
+    class  TextEditor final : public Base {
+        friend class Wawt;
+
+        // PRIVATE TYPES
+        struct Piece {
+            bool                d_added;    // in 'd_added', else 'd_original'
+            std::size_t         d_start;
+            std::size_t         d_length;
+        };
+        using Location = std::pair<std::size_t,std::size_t>; // piece, offset
+
+        // PRIVATE DATA MEMBERS
+        std::wstring                d_original{};
+        std::wstring                d_added{};
+        std::vector<Piece>          d_pieces{};
+        std::vector<std::size_t>    d_lineStarts{0};
+        std::vector<std::wstring>   d_visible{};    // from 'd_topLine'
+        std::vector<std::size_t>    d_visibleGenerations{}; // of each row
+        std::size_t                 d_visibleChanges = 0; // rows refreshed
+        mutable std::vector<DrawOptions> d_rowViews{}; // as last drawn
+        mutable std::size_t         d_rowGeneration = 0; // of options copied
+        std::size_t                 d_length    = 0;
+        std::size_t                 d_cursor    = 0;
+        std::size_t                 d_topLine   = 0;
+        unsigned int                d_rows      = 1;
+
+        // PRIVATE MANIPULATORS
+        bool            handleChar(wchar_t pressed);
+
+        void            refreshVisible(std::size_t firstLine,
+                                       std::size_t lastLine);
+
+        void            scrollToCursor();
+
+        // PRIVATE ACCESSORS
+        void            draw(DrawAdapter *adapter)        const;
+
+        Location        locate(std::size_t offset)        const;
+
+        void            rowView(DrawDirective *view, unsigned int row) const;
+
+      public:
+        // PUBLIC CONSTRUCTORS
+        TextEditor()                    = default;
+
+        TextEditor(Layout&&          layout,
+                   unsigned int      rows,
+                   std::wstring      document = std::wstring(),
+                   DrawOptions&&     options  = DrawOptions());
+
+        // PUBLIC MANIPULATORS
+        EventUpCb       downEvent(int x, int y);
+
+        void            erase(std::size_t offset, std::size_t count);
+
+        void            insert(std::size_t offset, const std::wstring& text);
+
+        void            setCursor(std::size_t offset);
+
+        void            setDocument(std::wstring document);
+
+        void            setTopLine(std::size_t line);
+
+        // PUBLIC ACCESSORS
+        std::size_t     cursor()                            const {
+            return d_cursor;
+        }
+
+        std::wstring    document()                          const;
+
+        std::size_t     length()                            const {
+            return d_length;
+        }
+
+        std::wstring    line(std::size_t index)             const;
+
+        std::size_t     lineOf(std::size_t offset)          const;
+
+        std::size_t     lines()                             const {
+            return d_lineStarts.size();
+        }
+
+        std::size_t     topLine()                           const {
+            return d_topLine;
+        }
+
+        unsigned int    windowSize()                        const {
+            return d_rows;
+        }
+    };
+
                                     //============
                                     // class Panel
                                     //============
@@ -1010,7 +1296,8 @@ class Wawt {
                                     Button,        // 3
                                     ButtonBar,     // 4
                                     List,          // 5
-                                    Panel>;        // 6
+                                    Panel,         // 6
+                                    TextEditor>;   // 7
 
         Panel()                             = default;
         
@@ -1049,11 +1336,186 @@ class Wawt {
             return const_cast<Panel*>(this)->lookup<WIDGET>(id, whatInfo);
         }
 
+        const DrawDirective *findView(WidgetId id) const;
+
         const std::list<Widget>& widgets() const {
             return d_widgets;
         }
 
       private:
+        // PRIVATE TYPES
+        // A step in the root panel's compiled layout: widget positions are
+        // computed by executing the steps instead of interpreting each
+        // widget's 'Layout' (see: 'Wawt::compileLayout').
+        struct LayoutStep {
+            enum Code : uint8_t {
+                  eWIDGET       ///< Apply defaults, and scale the layout
+                , eUPPER        ///< Position the upper left corner
+                , eLOWER        ///< Position the lower right corner
+                , eTIE          ///< Apply the layout's 'TieScale'
+                , eDONE         ///< Verify, and position any buttons
+            };
+            Code                    d_code;
+            Widget                 *d_widget;
+            Base                   *d_base;
+            const DrawDirective    *d_reference; // corner's context
+        };
+
+        // A command in the root panel's display list (see: 'Wawt::draw').
+        // The commands are in draw order and refer to the widgets' own
+        // directives and text, so replaying the list draws their current
+        // state without walking the tree; widgets with rows draw them.
+        // For an adapter that 'retainsFrame' each command also records what
+        // it last drew, so a frame can be limited to the damaged regions.
+        struct DisplayCommand {
+            enum Code : uint8_t {
+                  eWIDGET       ///< Draw the widget's directive
+                , eBUTTONBAR    ///< Draw a 'ButtonBar' and its buttons
+                , eLIST         ///< Draw a 'List' and its rows
+                , eTEXTEDITOR   ///< Draw a 'TextEditor' and its lines
+            };
+            Code                    d_code;
+            uint32_t                d_end;      // past last descendant
+            const Base             *d_base;
+            bool                    d_shown  = false; // as last drawn
+            DrawRegion              d_region {};      // as last drawn
+        };
+
+        // Only the root panel is indexed (see: 'Wawt::resolveWidgetIds').
+        // The entries point into 'd_widgets' which is why a copy of a panel
+        // starts with an empty index (the copy falls back to a tree walk).
+        // The index also holds the layout dependency graph: slot 0 stands
+        // for the root panel, and a widget's slot lists the slots of the
+        // widgets whose layouts reference it (see: 'Wawt::relayout'), and the
+        // compiled layout, which is recompiled when the generation changes.
+        // The compiled steps are partitioned into groups of root subtrees
+        // that do not reference each other (see: 'Wawt::setLayoutThreads').
+        // The display list is likewise recompiled when it is drawn after
+        // the generation changed.  Positions changed other than by a resize
+        // (see: 'Wawt::relayout') only bump 'd_positions', and any layout,
+        // rescale or restore bumps 'd_geometry'.  The slots of the widgets
+        // marked damaged (see: 'TreeLink::markDamaged') since the last frame
+        // are listed in 'd_damaged', 'd_commands' maps a slot to its
+        // command in the display list, and 'd_painted' lists the commands
+        // of widgets with paint functions.
+        struct Index {
+            using StepRange = std::pair<uint32_t, uint32_t>;
+
+            std::vector<Widget*>                d_widgets{};
+            std::vector<const DrawDirective*>   d_views{};
+            std::vector<Panel*>                 d_parents{};    // 0 if root
+            std::vector<std::vector<uint16_t>>  d_dependents{};
+            std::vector<uint16_t>               d_ranks{};      // topo. order
+            std::vector<LayoutStep>             d_layoutSteps{};
+            std::vector<std::vector<StepRange>> d_layoutGroups{};
+            std::size_t                         d_layoutGeneration = 0;
+            std::size_t                         d_generation = 0;
+            std::size_t                         d_positions = 0;
+            std::size_t                         d_geometry = 0;
+            mutable std::vector<DisplayCommand> d_display{};
+            mutable std::size_t                 d_displayGeneration = 0;
+            mutable std::size_t                 d_displayGeometry = 0;
+            mutable std::vector<uint32_t>       d_commands{};   // by slot
+            mutable std::vector<uint32_t>       d_painted{};    // commands
+            mutable std::vector<uint32_t>       d_damaged{};    // slots
+            mutable std::vector<bool>           d_isDamaged{};  // by slot
+            mutable std::size_t                 d_frames = 0;   // drawn
+
+            Index()                             = default;
+
+            Index(const Index&) : Index() { }
+
+            Index(Index&&)                      = default;
+
+            Index& operator=(const Index&) {
+                clear();
+                return *this;
+            }
+
+            Index& operator=(Index&&)           = default;
+
+            void clear() {
+                d_widgets.clear();
+                d_views.clear();
+                d_parents.clear();
+                d_dependents.clear();
+                d_ranks.clear();
+                d_layoutSteps.clear();
+                d_layoutGroups.clear();
+                d_display.clear();
+                d_commands.clear();
+                d_painted.clear();
+                d_damaged.clear();
+                d_isDamaged.clear();
+                d_generation += 1;
+            }
+
+            void markDamaged(std::size_t slot) {
+                if (slot >= d_isDamaged.size()) {
+                    d_isDamaged.resize(slot+1, false);
+                }
+
+                if (!d_isDamaged[slot]) {
+                    d_isDamaged[slot] = true;
+                    d_damaged.push_back(uint32_t(slot));
+                }
+            }
+
+            // Return the slots marked damaged since the last frame, which
+            // is counted as drawn.
+            std::vector<uint32_t> takeDamaged() const {
+                for (auto slot : d_damaged) {
+                    d_isDamaged[slot] = false;
+                }
+                auto slots = std::move(d_damaged);
+
+                d_damaged.clear();
+                d_frames += 1;
+                return slots;
+            }
+
+            bool empty() const {
+                return d_widgets.empty();
+            }
+
+            void insert(WidgetId             id,
+                        Widget              *widget,
+                        const DrawDirective *view) {
+                auto slot = std::size_t(id.value());
+
+                if (slot >= d_widgets.size()) {
+                    d_widgets.resize(slot+1, nullptr);
+                    d_views.resize(slot+1, nullptr);
+                    d_parents.resize(slot+1, nullptr);
+                    d_dependents.resize(slot+1);
+                    d_ranks.resize(slot+1, 0);
+                }
+                d_widgets[slot] = widget;
+                d_views[slot]   = view;
+                d_generation   += 1;
+            }
+
+            void truncate(WidgetId next) {
+                auto size = std::size_t(next.value());
+
+                if (size < d_widgets.size()) {
+                    d_widgets.resize(size);
+                    d_views.resize(size);
+                    d_parents.resize(size);
+                    d_dependents.resize(size);
+                    d_ranks.resize(size);
+
+                    // Pop-up edges were appended after all others:
+                    for (auto& dependents : d_dependents) {
+                        while (!dependents.empty()
+                            && dependents.back() >= size) {
+                            dependents.pop_back();
+                        }
+                    }
+                }
+                d_generation += 1;
+            }
+        };
 
         bool          findWidget(Widget **widget, WidgetId widgetId);
 
@@ -1064,6 +1526,304 @@ class Wawt {
         // callback whose closure would be contained in a moved widget.
         // Thus, a list is used instead of a vector.
         std::list<Widget> d_widgets;
+        Index             d_index;
+    };
+
+                                    //=================
+                                    // class FlatScreen
+                                    //=================
+
+    // A "compiled" copy of a root panel's widget tree.  Each widget (and
+    // each 'ButtonBar' button) is an entry, and the entries are stored in
+    // draw order (a panel precedes its children).  The widget tree remains
+    // the owner of all state; the compiled copy holds the geometry captured
+    // when it was compiled or last resized, and the tree structure, in
+    // contiguous arrays so drawing, resizing and hit-testing do not need to
+    // recurse through the widget variants (rescaling uses SIMD kernels on
+    // x86-64).  A compiled screen is recompiled automatically when pop-ups
+    // are added to, or removed from, the root.
+    // Once compiled, resize the screen through the 'FlatScreen' overload of
+    // 'resizeRootPanel' so the captured geometry stays current.
+    class  FlatScreen {
+        friend class Wawt;
+
+        // PRIVATE DATA MEMBERS
+        Panel                      *d_root       = nullptr;
+        std::size_t                 d_generation = 0;
+        std::size_t                 d_positions  = 0; // when captured
+        std::vector<Base*>          d_widgets{};   // owning widget
+        std::vector<uint8_t>        d_kinds{};     // 'Panel::Widget' index
+        std::vector<uint8_t>        d_flags{};     // see: 'Flags'
+        std::vector<uint32_t>       d_parents{};   // enclosing entry
+        std::vector<uint32_t>       d_ends{};      // past last descendant
+        std::vector<double>         d_ux{};        // upper left x
+        std::vector<double>         d_uy{};        // upper left y
+        std::vector<double>         d_lx{};        // lower right x
+        std::vector<double>         d_ly{};        // lower right y
+        std::vector<double>         d_borders{};   // layout border thickness
+        std::vector<double>         d_scaled{};    // rescaled border
+        std::vector<uint8_t>        d_reachable{}; // hit-test scratch
+
+      public:
+        // PUBLIC TYPES
+        enum Flags : uint8_t {
+              eCONTAINER = 0x01    ///< Entry is a 'Panel'
+            , eROW       = 0x02    ///< Entry is a 'ButtonBar' button
+            , eROWS      = 0x04    ///< Entry is a 'List' (rows not entries)
+        };
+
+        // PUBLIC MANIPULATORS
+        void clear();
+
+        // PUBLIC ACCESSORS
+        bool empty() const {
+            return d_widgets.empty();
+        }
+
+        std::size_t size() const {
+            return d_widgets.size();
+        }
+    };
+
+                                    //=====================
+                                    // class LayoutSnapshot
+                                    //=====================
+
+    // The results of laying out a root panel at one size: the geometry,
+    // character sizes and text metrics of every widget (and 'ButtonBar' and
+    // 'List' button), and the font size group assignments.  Restoring a
+    // snapshot (see: 'restoreLayout') reproduces the layout without
+    // interpreting it or measuring any text.  The text, alignment, and
+    // visibility of each entry are recorded so that a snapshot is rejected
+    // once they change; it is also rejected once the widget tree changes.
+    class  LayoutSnapshot {
+        friend class Wawt;
+
+        struct Entry {
+            DrawPosition            d_upperLeft;
+            DrawPosition            d_lowerRight;
+            double                  d_borderThickness;
+            double                  d_layoutBorder;
+            double                  d_startx;
+            unsigned int            d_charSize;
+            bool                    d_hidden;
+            TextMetrics             d_metrics;
+            TextString              d_text;
+        };
+
+        struct Rows {
+            double                  d_rowHeight;
+            unsigned int            d_rows;
+            int                     d_startRow;
+        };
+
+        // PRIVATE DATA MEMBERS
+        Panel                              *d_root       = nullptr;
+        std::size_t                         d_generation = 0;
+        std::size_t                         d_positions  = 0;
+        DrawPosition                        d_layoutSize{}; // root layout
+        std::vector<Entry>                  d_entries{};
+        std::vector<Rows>                   d_lists{};
+        std::map<FontSizeGrp, uint16_t>     d_fontIdToSize{};
+
+      public:
+        // PUBLIC MANIPULATORS
+        void clear();
+
+        // PUBLIC ACCESSORS
+
+        // Approximate heap memory held by the snapshot (in bytes).
+        std::size_t bytes() const;
+
+        bool empty() const {
+            return d_entries.empty();
+        }
+    };
+
+                                    //=======================
+                                    // class TextMetricsCache
+                                    //=======================
+
+    // A least recently used cache of 'DrawAdapter::getTextMetrics' results.
+    // A measurement is identified by the adapter's 'styleKey' for the
+    // widget, the size limit (or the character size if there is none), the
+    // box the text must fit in, and the text.  Widgets whose 'styleKey' is
+    // zero are always measured by the adapter.  The cache may be used
+    // concurrently.
+    class  TextMetricsCache {
+        struct Key {
+            std::size_t             d_style;
+            unsigned int            d_charSize;
+            double                  d_upperLimit;
+            TextMetrics             d_box;
+            std::wstring            d_text;
+
+            bool operator==(const Key& rhs) const {
+                return d_style              == rhs.d_style
+                    && d_charSize           == rhs.d_charSize
+                    && d_upperLimit         == rhs.d_upperLimit
+                    && d_box.d_textWidth    == rhs.d_box.d_textWidth
+                    && d_box.d_textHeight   == rhs.d_box.d_textHeight
+                    && d_text               == rhs.d_text;
+            }
+        };
+
+        struct Entry {
+            Key                     d_key;
+            unsigned int            d_charSize;
+            TextMetrics             d_metrics;
+        };
+
+        using Lru = std::list<Entry>;
+
+        // PRIVATE DATA MEMBERS
+        mutable std::mutex                                      d_lock;
+        std::size_t                                             d_capacity;
+        Lru                                                     d_lru;
+        std::unordered_multimap<std::size_t, Lru::iterator>     d_index;
+        std::size_t                                             d_hits;
+        std::size_t                                             d_misses;
+
+        // PRIVATE CLASS MEMBERS
+        static std::size_t hash(const Key& key);
+
+        // PRIVATE MANIPULATORS
+        void trim(); // discard entries over capacity (lock must be held)
+
+      public:
+        // PUBLIC CONSTRUCTORS
+        explicit TextMetricsCache(std::size_t capacity = 4096)
+            : d_lock()
+            , d_capacity(capacity)
+            , d_lru()
+            , d_index()
+            , d_hits(0)
+            , d_misses(0) { }
+
+        // PUBLIC MANIPULATORS
+        void clear();
+
+        // Set 'args->d_charSize' and '*metrics' as 'adapter' would, calling
+        // it only if the result is not cached.
+        void measure(DrawAdapter           *adapter,
+                     DrawDirective         *args,
+                     TextMetrics           *metrics,
+                     const std::wstring&    text,
+                     double                 upperLimit);
+
+        void resetCounters();
+
+        // Discard the least recently used entries above 'capacity' ('0'
+        // disables the cache).
+        void setCapacity(std::size_t capacity);
+
+        // PUBLIC ACCESSORS
+        std::size_t capacity() const;
+
+        std::size_t hits()     const;
+
+        std::size_t misses()   const;
+
+        std::size_t size()     const;
+    };
+
+    // The directives, and their texts, of a frame in draw order (see:
+    // 'DrawAdapter::drawBatch').  They refer to the widgets, so are only
+    // valid until the widgets change.  Each is clipped to the region
+    // returned by 'clip' (see: 'DrawAdapter::setClip').
+    struct  DrawBatch {
+        std::vector<const DrawDirective*>   d_directives;
+        std::vector<const std::wstring*>    d_texts;
+        std::vector<uint32_t>               d_clips;   // 1 + 'd_regions'
+        std::vector<DrawRegion>             d_regions; // index, or 0
+
+        void clear() {
+            d_directives.clear();
+            d_texts.clear();
+            d_clips.clear();
+            d_regions.clear();
+        }
+
+        const DrawRegion *clip(std::size_t index) const {
+            return d_clips[index] ? &d_regions[d_clips[index] - 1] : nullptr;
+        }
+
+        std::size_t size() const {
+            return d_directives.size();
+        }
+    };
+
+                                    //=================
+                                    // class StyleTable
+                                    //=================
+
+    // Draw options shared by the widgets that refer to them by 'StyleId'
+    // (see: 'Wawt::setStyleTable'), instead of each holding a copy.  Once
+    // it is set the table is not changed; a theme is changed by setting
+    // another table with the same IDs.  ID 0 is reserved for "no style".
+    class  StyleTable {
+        std::vector<std::any>   d_styles;
+
+      public:
+        // PUBLIC CONSTRUCTORS
+        StyleTable() : d_styles(1) { }
+
+        // PUBLIC MANIPULATORS
+
+        // Return the ID of 'options'.  Throw 'Wawt::Exception' if the table
+        // is full.
+        StyleId add(std::any options);
+
+        // PUBLIC ACCESSORS
+        const std::any& options(StyleId id) const {
+            return id < d_styles.size() ? d_styles[id] : d_styles[0];
+        }
+
+        std::size_t size() const {
+            return d_styles.size();
+        }
+    };
+
+                                    //=================
+                                    // class ThreadPool
+                                    //=================
+
+    // A fixed set of threads that run batches of independent tasks (e.g.
+    // the root subtrees laid out by 'Wawt::setLayoutThreads', or the tiles
+    // of an adapter's frame).
+    class  ThreadPool {
+        // PRIVATE DATA MEMBERS
+        std::mutex                          d_lock;
+        std::condition_variable             d_ready;
+        std::condition_variable             d_done;
+        std::deque<std::function<void()>>   d_queue;
+        std::size_t                         d_pending;
+        bool                                d_stop;
+        std::vector<std::thread>            d_threads;
+
+        // PRIVATE MANIPULATORS
+        void work();
+
+      public:
+        // PUBLIC CONSTRUCTORS
+        explicit ThreadPool(unsigned int threads);
+
+        ThreadPool(const ThreadPool&)               = delete;
+
+        ThreadPool& operator=(const ThreadPool&)    = delete;
+
+        ~ThreadPool();
+
+        // PUBLIC MANIPULATORS
+
+        // Run all of 'tasks' (which must not throw) and wait for them.  The
+        // calling thread counts as one of the pool's threads.
+        void run(std::vector<std::function<void()>>&& tasks);
+
+        // PUBLIC ACCESSORS
+        unsigned int size() const {
+            return unsigned(d_threads.size()) + 1;
+        }
     };
 
                                     //==================
@@ -1079,6 +1839,83 @@ class Wawt {
                                      Wawt::TextMetrics     *metrics,
                                      const std::wstring&   text,
                                      double                upperLimit = 0) = 0;
+
+        // Return a non-zero key identifying everything in 'parameters'
+        // (e.g. font and boldness) that 'getTextMetrics' results depend on
+        // other than the text, character size, and box; or zero if they
+        // must not be cached (see: 'Wawt::TextMetricsCache').
+        virtual std::size_t styleKey(const Wawt::DrawDirective&) const {
+            return 0;
+        }
+
+        // Return 'true' if 'getTextMetrics' may be called concurrently
+        // (see: 'Wawt::setLayoutThreads').
+        virtual bool  threadSafe() const {
+            return false;
+        }
+
+        // Called with the table a directive's 'd_style' refers to (and
+        // again whenever it is replaced, e.g. to precompute each style's
+        // colors).
+        virtual void  setStyleTable(
+                            const std::shared_ptr<const Wawt::StyleTable>&) {
+        }
+
+        // Return 'true' if the directives of a root panel are to be passed
+        // to 'drawBatch', rather than one at a time to 'draw'.
+        virtual bool  drawsBatches() const {
+            return false;
+        }
+
+        // Draw the directives in 'batch' in order (e.g. after sorting them
+        // by state where they do not overlap).  A widget with a paint
+        // function ends a batch, as it is painted in order.
+        virtual void  drawBatch(const Wawt::DrawBatch& batch) {
+            auto clip = static_cast<const Wawt::DrawRegion*>(nullptr);
+
+            for (auto i = 0u; i < batch.size(); ++i) {
+                if (batch.clip(i) != clip) {
+                    clip = batch.clip(i);
+                    setClip(clip);
+                }
+                draw(*batch.d_directives[i], *batch.d_texts[i]);
+            }
+
+            if (clip) {
+                setClip(nullptr);
+            }
+        }
+
+        // Called with the region the directives drawn next are to be
+        // clipped to (their panel's box), or null when they are not (see:
+        // 'Wawt::setPanelClipping').  Directives entirely outside it are
+        // not drawn.
+        virtual void  setClip(const Wawt::DrawRegion*) {
+        }
+
+        // Return 'true' if the adapter keeps the previous frame, so a new
+        // frame need only repaint the regions that changed (see: 'damage').
+        virtual bool  retainsFrame() const {
+            return false;
+        }
+
+        // Called before each frame when 'retainsFrame' with the regions
+        // that changed since the last frame, or with 'wholeFrame' set if
+        // that frame was of another screen.  Return 'true' if only the
+        // widgets overlapping 'regions' are to be drawn (the adapter clips
+        // to the regions and keeps the rest), or 'false' to have the whole
+        // frame drawn (e.g. the retained frame was lost).
+        virtual bool  damage(const std::vector<Wawt::DrawRegion>&, bool) {
+            return false;
+        }
+
+        // Return 'true' if drawing 'parameters' paints every pixel of its
+        // box opaquely (e.g. its fill has no transparency), so the widgets
+        // drawn before it that it covers need not be drawn (see:
+        // 'Wawt::setOcclusionCulling').
+        virtual bool  opaque(const Wawt::DrawDirective&) const {
+            return false;
+        }
     };
 
     //! Wawt runtime exception
@@ -1116,6 +1953,37 @@ class Wawt {
         unsigned int d_panelThickness     = 0u;
     };
 
+    // When the root panel is resized, its layout is either interpreted at
+    // the new size, or the current positions are rescaled (which is faster
+    // but accumulates error).  The policy selects between the two:
+    struct  ResizePolicy {
+        enum class Mode {
+              eRATIO        ///< Interpret if size changed by over 'd_ratio'
+            , eINTERPRET    ///< Always interpret
+            , eDRIFT        ///< Interpret if size moved over 'd_maxDrift'
+            , eIDLE         ///< Rescale; interpret on 'idle'
+        };
+        Mode         d_mode     = Mode::eRATIO;
+        double       d_ratio    = 0.25; ///! Relative size change (eRATIO)
+        double       d_maxDrift = 8.0;  ///! Pixel size change (eDRIFT)
+    };
+
+    struct  ResizeCounters {
+        std::size_t  d_interpreted = 0; ///! Resizes that interpreted
+        std::size_t  d_rescaled    = 0; ///! Resizes that rescaled
+        std::size_t  d_deferred    = 0; ///! Interpretations run by 'idle'
+    };
+
+    struct  DrawCounters {
+        std::size_t  d_frames      = 0; ///! Root panels drawn
+        std::size_t  d_partial     = 0; ///! Frames drawing only damage
+        std::size_t  d_drawn       = 0; ///! Display commands drawn
+        std::size_t  d_skipped     = 0; ///! Commands outside the damage
+        std::size_t  d_batches     = 0; ///! Calls to 'drawBatch'
+        std::size_t  d_culled      = 0; ///! Commands under opaque widgets
+        std::size_t  d_clipped     = 0; ///! Commands outside their panel
+    };
+
     struct  WidgetOptionDefaults {
         std::any     d_screenOptions;    ///! Options for root Panel
         std::any     d_canvasOptions;    ///! Default Canvas options
@@ -1125,16 +1993,32 @@ class Wawt {
         std::any     d_buttonBarOptions; ///! Default ButtonBar options
         std::any     d_listOptions;      ///! Default List options
         std::any     d_panelOptions;     ///! Default Panel options
+        // Styles (see: 'StyleTable') are used instead of copying the
+        // options into each widget when they are set:
+        StyleId      d_screenStyle    = 0; ///! Style for root Panel
+        StyleId      d_canvasStyle    = 0; ///! Default Canvas style
+        StyleId      d_textEntryStyle = 0; ///! Default TextEntry style
+        StyleId      d_labelStyle     = 0; ///! Default Label style
+        StyleId      d_buttonStyle    = 0; ///! Default Button style
+        StyleId      d_buttonBarStyle = 0; ///! Default ButtonBar style
+        StyleId      d_listStyle      = 0; ///! Default List style
+        StyleId      d_panelStyle     = 0; ///! Default Panel style
     };
 
     // PUBLIC CLASS DATA
     static wchar_t   s_downArrow;
     static wchar_t   s_upArrow;
+    // Deprecated: Wawt no longer draws 's_cursor' (the caret is passed to
+    // adapters as 'DrawDirective::d_cursor'); kept for those that do.
     static wchar_t   s_cursor;
 
     static const std::any  s_noOptions;
 
     // PUBLIC CLASS MEMBERS
+    static void    compileScreen(FlatScreen *compiled, Panel *root);
+
+    static EventUpCb downEvent(FlatScreen *compiled, int x, int y);
+
     static void    scalePosition(Panel::Widget  *widget,
                                  const Scale&    scale,
                                  double          borderScale);
@@ -1154,30 +2038,149 @@ class Wawt {
 
     explicit Wawt(DrawAdapter *adapter) : Wawt(TextMapper(), adapter) { }
 
+    ~Wawt();
+
     // PUBLIC MANIPULATORS
+
+    // A root panel (once its widget IDs are resolved) is drawn by replaying
+    // its display list, which is recompiled only after the widget tree or
+    // its layout changed.  Its directives are passed in batches to an
+    // adapter that 'drawsBatches'.
     void  draw(const Panel& panel);
 
+    void  draw(FlatScreen *compiled);
+
+    // Interpret the layout if it was deferred by an 'eIDLE' resize policy.
+    // Return 'true' if positions changed (i.e. the screen needs redrawing).
+    bool  idle(Panel *root);
+
     void  popUpModalDialogBox(Panel *root, Panel&& dialogBox);
 
+    // Refresh the text metrics of only the widgets whose text or
+    // enablement changed (see: 'TreeLink') since the last call.  Changes
+    // made through the references returned by 'TextBlock::alignment' and
+    // 'TextBlock::fontSizeGrp' are not tracked ('refreshTextMetrics'
+    // refreshes every widget).
+    void  refreshChangedTextMetrics(Panel *root);
+
     void  refreshTextMetrics(Panel *panel);
 
+    // Recompute the position of widget 'id' (after its layout was changed)
+    // and of the widgets whose layouts depend on it, in dependency order.
+    void  relayout(Panel *root, WidgetId id);
+
     void  resizeRootPanel(Panel   *root, double  width, double  height);
 
+    void  resizeRootPanel(FlatScreen *compiled, double width, double height);
+
     void  resolveWidgetIds(Panel *root);
 
+    // Restore the layout recorded in 'snapshot'.  Return 'false' (leaving
+    // the positions unchanged) if the snapshot no longer matches the tree.
+    bool  restoreLayout(Panel *root, const LayoutSnapshot& snapshot);
+
+    bool  restoreLayout(FlatScreen *compiled, const LayoutSnapshot& snapshot);
+
+    void resetDrawCounters() {
+        d_drawCounters = DrawCounters();
+    }
+
+    void resetResizeCounters() {
+        d_resizeCounters = ResizeCounters();
+    }
+
     void setBorderThicknessDefaults(const BorderThicknessDefaults& defaults) {
         d_borderDefaults = defaults;
     }
 
+    // Lay out root subtrees that do not reference each other on a pool of
+    // 'threads' threads ('0' or '1' lays out serially, the default).  Text
+    // is only measured in parallel if the adapter is 'threadSafe'.
+    void setLayoutThreads(unsigned int threads);
+
+    void setResizePolicy(const ResizePolicy& policy) {
+        d_resizePolicy = policy;
+    }
+
+    // Skip drawing the widgets of a root panel whose boxes are covered by
+    // a widget drawn after them that the adapter reports to be 'opaque'
+    // (e.g. a screen under a modal dialog box).  Off by default.
+    void setOcclusionCulling(bool enable) {
+        d_cullOccluded = enable;
+    }
+
+    // Clip the widgets of each panel of a root panel to the panel's box
+    // (see: 'DrawAdapter::setClip'), skipping those, and the rows of lists
+    // and button bars, that are entirely outside it.  Off by default, as a
+    // layout may place widgets outside their panel.
+    void setPanelClipping(bool enable) {
+        d_clipPanels = enable;
+    }
+
+    // Share 'styles' with the adapter (see: 'DrawAdapter::setStyleTable').
+    // Replacing a table with one using the same IDs (e.g. to change the
+    // colors) only redraws; if its styles are measured differently the
+    // screens must be resized.
+    void setStyleTable(std::shared_ptr<const StyleTable> styles);
+
+    // Replace the mapping from 'TextId' to strings (e.g. on a change of
+    // language).  The strings are mapped again in one pass; a screen shows
+    // them once it is resized or its text is set again.
+    void setTextMapper(const TextMapper& mappingFn) {
+        d_textTable.setMapper(mappingFn);
+    }
+
     void setWidgetOptionDefaults(const WidgetOptionDefaults& defaults) {
         d_optionDefaults = defaults;
     }
 
+    // The cache shared by all text measurements (e.g. to change its
+    // capacity, or to reset its hit and miss counters).
+    TextMetricsCache& textMetricsCache() {
+        return d_textMetricsCache;
+    }
+
     // PUBLIC ACCESSORS
+
+    // Record the current layout of 'root' (normally just after it was
+    // resized) in 'snapshot'.
+    void saveLayout(LayoutSnapshot *snapshot, Panel *root) const;
+
     const WidgetOptionDefaults& getWidgetOptionDefaults() const {
         return d_optionDefaults;
     }
 
+    const DrawCounters& drawCounters()                const {
+        return d_drawCounters;
+    }
+
+    unsigned int layoutThreads()                      const;
+
+    const std::shared_ptr<const StyleTable>& styleTable() const {
+        return d_styleTable;
+    }
+
+    const ResizeCounters& resizeCounters()            const {
+        return d_resizeCounters;
+    }
+
+    const ResizePolicy& resizePolicy()                const {
+        return d_resizePolicy;
+    }
+
+    const TextMapper& textMapper()                    const {
+        return d_textTable.mapper();
+    }
+
+    // Changed by each call to 'setTextMapper'.
+    uint32_t textMapperGeneration()                   const {
+        return d_textTable.generation();
+    }
+
+    const TextMetricsCache& textMetricsCache()        const {
+        return d_textMetricsCache;
+    }
+
     const std::any& defaultScreenOptions()            const {
         return d_optionDefaults.d_screenOptions;
     }
@@ -1217,8 +2220,68 @@ class Wawt {
     // PRIVATE TYPE
     using FontIdMap  = std::map<FontSizeGrp, uint16_t>;
 
+    struct Clip {           // a panel's box, clipping its widgets
+        DrawRegion              d_region;
+        std::size_t             d_end;      // past the panel's last widget
+    };
+
+    struct Opaque {         // an opaque directive of the display list
+        std::size_t             d_index;
+        DrawRegion              d_box;      // the pixels it paints
+    };
+
     // PRIVATE CLASS MEMBERS
-    static void setIds(Panel::Widget *widget, WidgetId& id);
+    static void completeWidgetAdapterValues(
+            Panel::Widget                  *widget,
+            const Scale&                    scale,
+            const BorderThicknessDefaults&  border,
+            const WidgetOptionDefaults&     option);
+
+    static void compileEntry(FlatScreen     *compiled,
+                             Base           *base,
+                             std::size_t     kind,
+                             uint32_t        parent);
+
+    static void captureGeometry(FlatScreen *compiled);
+
+    static void compileDisplay(const Panel& root);
+
+    static void compileDisplayCommands(
+            std::vector<Panel::DisplayCommand> *display,
+            const Base&                         base,
+            std::size_t                         kind);
+
+    // Return 'true' if a directive the shown 'command' draws would not be
+    // drawn as it was last drawn.
+    static bool displayChanged(const Panel::DisplayCommand& command);
+
+    static void collectBases(Panel              *panel,
+                             std::vector<Base*> *bases,
+                             std::vector<List*> *lists);
+
+    static bool compileLayout(Panel *root);
+
+    static bool compileLayoutSteps(Panel           *root,
+                                   Panel           *parent,
+                                   Panel::Widget   *widget);
+
+    static bool isCurrent(const FlatScreen& compiled);
+
+    // Rebuild the dependency edges of the widget in 'slot' from its
+    // layout, re-ranking the widgets if they changed (throwing, with the
+    // edges unchanged, if they form a cycle).  Return 'true' if the
+    // compiled layout steps no longer match the layout.
+    static bool relinkLayout(Panel *root, std::size_t slot);
+
+    static void rescaleCompiled(FlatScreen     *compiled,
+                                const Scale&    scale,
+                                double          borderScale);
+
+    static void setDependencies(Panel           *root,
+                                Panel           *parent,
+                                Panel::Widget   *widget);
+
+    static void setIds(Panel::Widget *widget, WidgetId& id, Panel *root);
 
     static void setWidgetAdapterPositions(
             Panel::Widget                  *widget,
@@ -1228,17 +2291,81 @@ class Wawt {
             const BorderThicknessDefaults&  border,
             const WidgetOptionDefaults&     option);
 
+    static void setWidgetAdapterValues(
+            Panel::Widget                  *widget,
+            Panel                          *root,
+            const Panel&                    panel,
+            const Scale&                    scale,
+            const BorderThicknessDefaults&  border,
+            const WidgetOptionDefaults&     option);
+
+    static void setWidgetDefaults(Panel::Widget                  *widget,
+                                  Base                           *base,
+                                  const BorderThicknessDefaults&  border,
+                                  const WidgetOptionDefaults&     option);
+
+    static void sortDependencies(Panel *root);
+
     // PRIVATE MANIPULATORS
+    void  addDamage(const DrawRegion& region);
+
+    bool  collectDamage(const Panel&                              root,
+                        const std::vector<Panel::DisplayCommand>& previous);
+
+    void  drawDisplay(const Panel& root);
+
+    // Return the region the command at 'index' of a display list being
+    // walked in order is clipped to (null if none), and if it is a panel,
+    // clip its widgets to its box within that region.
+    const DrawRegion *enterClip(const Panel::DisplayCommand& command,
+                                std::size_t                  index);
+
+    void  executeLayout(Panel *root, const Scale& scale);
+
+    void  executeSteps(const Panel::LayoutStep  *begin,
+                       const Panel::LayoutStep  *end,
+                       const Scale&              scale);
+
+    void  interpretRootPanel(Panel *root);
+
+    void  layoutRootPanel(Panel *root, double width, double height);
+
+    void  markOccluded(const Panel& root);
+
+    void  refreshChanges(Panel *root, Panel *panel);
+
+    void  refreshRootTextMetrics(Panel *root);
+
+    void  refreshTextMetrics(Panel::Widget *widget);
+
+    void  resize(Panel *root, double width, double height, FlatScreen *flat);
+
     void  setFontSizeEntry(Base *args);
 
     void  setTextAndFontValues(Panel *root);
 
     // PRIVATE DATA
     DrawAdapter             *d_adapter_p;
-    TextMapper               d_idToString;
+    TextTable                d_textTable;
     FontIdMap                d_fontIdToSize;
     BorderThicknessDefaults  d_borderDefaults;
     WidgetOptionDefaults     d_optionDefaults;
+    ResizePolicy             d_resizePolicy;
+    ResizeCounters           d_resizeCounters;
+    DrawCounters             d_drawCounters;
+    const Panel             *d_damageRoot; // screen in the retained frame
+    std::size_t              d_damageFrame; // ... and its 'd_frames'
+    std::vector<DrawRegion>  d_damage;
+    bool                     d_cullOccluded;
+    std::vector<bool>        d_occluded;    // by display command
+    std::vector<DrawRegion>  d_occluders;   // see: 'markOccluded'
+    std::vector<Opaque>      d_opaque;      // ... in display order
+    bool                     d_clipPanels;
+    std::vector<Clip>        d_clips;       // the panels being drawn
+    DrawBatch                d_batch;
+    std::shared_ptr<const StyleTable> d_styleTable;
+    TextMetricsCache         d_textMetricsCache;
+    std::unique_ptr<ThreadPool> d_layoutPool;
 };
 
 template<class WIDGET>
@@ -1291,11 +2418,175 @@ class  WawtDump : public Wawt::DrawAdapter {
                             const std::wstring&   text,
                             double                upperLimit = 0) override;
 
+    std::size_t styleKey(const Wawt::DrawDirective&) const override {
+        return 1; // measurements do not depend on the options
+    }
+
   private:
     Indent         d_indent;
     std::wostream& d_dumpOs;
 };
 
+                            //======================
+                            // class  WawtAdapterImpl
+                            //======================
+
+// A base for an adapter whose widgets' options are all of type 'Option'
+// (or unset, which draws with a default constructed 'Option').  The
+// options are resolved without a copy, and the adapter's methods are then
+// called directly (this is the Curious Recursive Template Pattern).  The
+// 'Derived' class implements:
+//
+//  void        drawWidget(const Wawt::DrawDirective&  widget,
+//                         const Option&               options,
+//                         const std::wstring&         text);
+//
+//  void        textMetrics(Wawt::DrawDirective   *parameters,
+//                          const Option&          options,
+//                          Wawt::TextMetrics     *metrics,
+//                          const std::wstring&    text,
+//                          double                 upperLimit);
+//
+// and optionally 'std::size_t optionsKey(const Option&) const' (see:
+// 'DrawAdapter::styleKey'), which otherwise disables caching metrics,
+// 'bool opaqueWidget(const Wawt::DrawDirective&, const Option&) const'
+// (see: 'DrawAdapter::opaque'), which otherwise culls nothing, and
+// 'void prepareStyles(const std::vector<const Option*>&)' which is called
+// with the options of each style in a new style table (slot 0 is null).
+template<class Derived, class Option>
+class  WawtAdapterImpl : public Wawt::DrawAdapter {
+    // PRIVATE DATA
+    std::shared_ptr<const Wawt::StyleTable> d_styleTable;
+    std::vector<const Option*>              d_styles; // in 'd_styleTable'
+
+    Derived *derived() {
+        return static_cast<Derived*>(this);
+    }
+
+  public:
+    // PUBLIC Wawt::DrawAdapter INTERFACE
+    void  draw(const Wawt::DrawDirective&  widget,
+               const std::wstring&         text)                 override {
+        derived()->drawWidget(widget, options(widget), text);
+    }
+
+    void  drawBatch(const Wawt::DrawBatch& batch)                override {
+        auto clip = static_cast<const Wawt::DrawRegion*>(nullptr);
+
+        for (auto i = 0u; i < batch.size(); ++i) {
+            auto& widget = *batch.d_directives[i];
+
+            if (batch.clip(i) != clip) {
+                clip = batch.clip(i);
+                setClip(clip);
+            }
+            derived()->drawWidget(widget, options(widget), *batch.d_texts[i]);
+        }
+
+        if (clip) {
+            setClip(nullptr);
+        }
+    }
+
+    void  getTextMetrics(Wawt::DrawDirective   *parameters,
+                         Wawt::TextMetrics     *metrics,
+                         const std::wstring&    text,
+                         double                 upperLimit = 0)  override {
+        derived()->textMetrics(parameters,
+                               options(*parameters),
+                               metrics,
+                               text,
+                               upperLimit);
+    }
+
+    bool  opaque(const Wawt::DrawDirective& widget)  const        override {
+        return static_cast<const Derived*>(this)
+                                    ->opaqueWidget(widget, options(widget));
+    }
+
+    void  setStyleTable(const std::shared_ptr<const Wawt::StyleTable>& styles)
+                                                                 override;
+
+    std::size_t styleKey(const Wawt::DrawDirective& parameters) const
+                                                                 override {
+        return static_cast<const Derived*>(this)
+                                        ->optionsKey(options(parameters));
+    }
+
+    // PUBLIC MANIPULATORS
+    void  prepareStyles(const std::vector<const Option*>&) {
+    }
+
+    // PUBLIC ACCESSORS
+
+    // Return the options of 'widget' (those of its style if it has one).
+    // Throw 'Wawt::Exception' if they are not an 'Option'.
+    const Option& options(const Wawt::DrawDirective& widget) const;
+
+    std::size_t optionsKey(const Option&) const {
+        return 0;
+    }
+
+    bool  opaqueWidget(const Wawt::DrawDirective&, const Option&) const {
+        return false;
+    }
+};
+
+template<class Derived, class Option>
+void
+WawtAdapterImpl<Derived,Option>::setStyleTable(
+                        const std::shared_ptr<const Wawt::StyleTable>& styles)
+{
+    d_styleTable = styles;
+    d_styles.assign(styles ? styles->size() : 1, nullptr);
+
+    for (auto id = 1u; id < d_styles.size(); ++id) {
+        d_styles[id] = std::any_cast<Option>(&styles->options(id));
+
+        if (!d_styles[id]) {
+            throw Wawt::Exception("Bad options (any_cast). Style="
+                                                  + std::to_string(id));//THROW
+        }
+    }
+    derived()->prepareStyles(d_styles);
+    return;                                                           // RETURN
+}
+
+template<class Derived, class Option>
+const Option&
+WawtAdapterImpl<Derived,Option>::options(
+                                    const Wawt::DrawDirective& widget) const
+{
+    static const Option s_default{};
+
+    if (widget.d_style != 0) {
+        if (widget.d_style >= d_styles.size()) {
+            throw Wawt::Exception("Unknown style="
+                                  + std::to_string(widget.d_style));  // THROW
+        }
+        return *d_styles[widget.d_style];                             // RETURN
+    }
+
+    if (!widget.d_options.has_value()) {
+        return s_default;                                             // RETURN
+    }
+    auto option = std::any_cast<Option>(&widget.d_options);
+
+    if (!option) {
+        auto [type, wid, idx] = widget.d_tracking;
+        std::string msg = "Bad options (any_cast). Widget="
+                        + std::to_string(wid);
+        if (idx >= 0) {
+            msg += " row=" + std::to_string(idx);
+        }
+        else {
+            msg += " index=" + std::to_string(type);
+        }
+        throw Wawt::Exception(msg);                                     // THROW
+    }
+    return *option;                                                   // RETURN
+}
+
 // FREE OPERATORS
 
 inline
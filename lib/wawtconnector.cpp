@@ -130,6 +130,19 @@ WawtConnector::draw()
     }
 }
 
+bool
+WawtConnector::idle()
+{
+    std::unique_lock<FairMutex> guard(d_lock);
+    auto hold = d_pending.load();
+
+    if (hold && hold != d_current) {
+        d_current = hold;
+        ++d_loadCount;
+    }
+    return d_current && d_current->idle();
+}
+
 void
 WawtConnector::resize(int width, int height)
 {
@@ -151,6 +164,23 @@ WawtConnector::resize(int width, int height)
     } while (hold != d_pending.load());
 }
 
+void
+WawtConnector::setTextMapper(const Wawt::TextMapper& textMapper)
+{
+    std::unique_lock<FairMutex> guard(d_lock);
+    auto hold = d_pending.load();
+
+    if (hold && hold != d_current) {
+        d_current = hold;
+        ++d_loadCount;
+    }
+    d_wawt.setTextMapper(textMapper);
+
+    if (d_current) {
+        d_current->resize();
+    }
+}
+
 void
 WawtConnector::shutdownRequested(const std::function<void()>& completion)
 {
@@ -89,6 +89,8 @@ class WawtConnector {
     
     void draw();
 
+    bool idle();
+
     template<typename Func, typename... Args>
     decltype(auto) call(Func&& func, Args&&... args) {
         std::unique_lock<FairMutex> guard(d_lock);
@@ -99,6 +101,11 @@ class WawtConnector {
 
     void resize(int width, int height);
 
+    // Replace the mapping of 'TextId' values to strings (e.g. on a change
+    // of language).  The current screen is resized to show the new
+    // strings; the others show them when next activated.
+    void setTextMapper(const Wawt::TextMapper& textMapper);
+
     template <class Screen, typename... Args>
     void setupScreen(Screen                          *screen,
                      std::string_view                 name,
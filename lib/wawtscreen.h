@@ -23,6 +23,7 @@
 
 #include <any>
 #include <experimental/type_traits>
+#include <list>
 #include <string>
 #include <typeinfo>
 #include <utility>
@@ -65,6 +66,7 @@ class WawtScreen {
     using List       = Wawt::List;
     using Panel      = Wawt::Panel;
     using TieScale   = Wawt::TieScale;
+    using TextEditor = Wawt::TextEditor;
     using TextEntry  = Wawt::TextEntry;
     using Metric     = Wawt::Metric;
     using Vertex     = Wawt::Vertex;
@@ -82,14 +84,68 @@ class WawtScreen {
         : d_wawt()
         , d_name()
         , d_screen()
+        , d_compiled()
+        , d_layoutCache()
+        , d_layoutCacheLimit(0)
+        , d_textGeneration(0)
         , d_close(std::move(closeFn)) { }
 
+    // PROTECTED TYPES
+    struct CachedLayout {
+        int                   d_width;
+        int                   d_height;
+        Wawt::LayoutSnapshot  d_snapshot;
+    };
+
     // PROTECTED MANIPULATOR
 
+    bool restoreCachedLayout(int width, int height) {
+        for (auto it = d_layoutCache.begin(); it != d_layoutCache.end(); ++it) {
+            if (it->d_width == width && it->d_height == height) {
+                auto restored = d_compiled.empty()
+                    ? d_wawt->restoreLayout(&d_screen,   it->d_snapshot)
+                    : d_wawt->restoreLayout(&d_compiled, it->d_snapshot);
+
+                if (restored) {
+                    d_layoutCache.splice(d_layoutCache.begin(),
+                                         d_layoutCache,
+                                         it);
+                }
+                else { // stale: the screen has changed since it was saved
+                    d_layoutCache.erase(it);
+                }
+                return restored;                                      // RETURN
+            }
+        }
+        return false;                                                 // RETURN
+    }
+
+    void saveCachedLayout(int width, int height) {
+        d_layoutCache.push_front({width, height, Wawt::LayoutSnapshot()});
+        d_wawt->saveLayout(&d_layoutCache.front().d_snapshot, &d_screen);
+
+        auto total = std::size_t(0);
+
+        for (auto it = d_layoutCache.begin(); it != d_layoutCache.end();) {
+            total += it->d_snapshot.bytes();
+
+            if (it != d_layoutCache.begin() && total > d_layoutCacheLimit) {
+                it = d_layoutCache.erase(it, d_layoutCache.end());
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
     // PROTECTED DATA MEMBERS
     Wawt                  *d_wawt;           ///< Holder of the WAWT adapters.
     std::string            d_name;           ///< Identifier for the screen.
     Wawt::Panel            d_screen;         ///< Root WAWT element.
+    Wawt::FlatScreen       d_compiled;       ///< Optional compiled screen.
+    std::list<CachedLayout> d_layoutCache;   ///< Most recently used first.
+    std::size_t            d_layoutCacheLimit; ///< Cache size limit (bytes).
+    uint32_t               d_textGeneration; ///< Text mapper last resized.
     CloseFn                d_close;          ///< Call into Impl close method.
 
   public:
@@ -156,9 +212,16 @@ class WawtScreen {
      * than 'panel' from receiving any mouse event.
      */
     void addModalDialogBox(Wawt::Panel panel) {
-        if (!panel.drawView().options().has_value()) {
-            panel.drawView().options() = d_wawt->getWidgetOptionDefaults()
-                                               .d_screenOptions;
+        auto& defaults = d_wawt->getWidgetOptionDefaults();
+
+        if (!panel.adapterView().d_options.has_value()
+         && panel.adapterView().d_style == 0) {
+            if (defaults.d_screenStyle != 0) {
+                panel.drawView().style()   = defaults.d_screenStyle;
+            }
+            else {
+                panel.drawView().options() = defaults.d_screenOptions;
+            }
         }
         d_wawt->popUpModalDialogBox(&d_screen, std::move(panel));
     }
@@ -194,7 +257,12 @@ class WawtScreen {
      */
     void draw() {
         try {
-            d_wawt->draw(d_screen);
+            if (d_compiled.empty()) {
+                d_wawt->draw(d_screen);
+            }
+            else {
+                d_wawt->draw(&d_compiled);
+            }
         }
         catch (Wawt::Exception caught) {
             throw Wawt::Exception("Painting: '" + d_name + "', "
@@ -237,7 +305,8 @@ class WawtScreen {
      */
     Wawt::EventUpCb downEvent(int x, int y) {
         try {
-            return d_screen.downEvent(x, y);
+            return d_compiled.empty() ? d_screen.downEvent(x, y)
+                                      : Wawt::downEvent(&d_compiled, x, y);
         }
         catch (Wawt::Exception caught) {
             throw Wawt::Exception("Click on screen '" + d_name + "', "
@@ -245,6 +314,28 @@ class WawtScreen {
         }
     }
 
+    /**
+     * @brief Complete a layout deferred while the screen was being resized.
+     *
+     * @return 'true' if the screen changed and should be redrawn.
+     *
+     * @throws Wawt::Exception Rethrows intercepted Wawt::Exeption with the
+     * screen name attached to the exception message.
+     *
+     * This method should be called when user input pauses (e.g. after a
+     * window drag-resize ends).  It only has an effect when the resize
+     * policy mode is 'Wawt::ResizePolicy::Mode::eIDLE'.
+     */
+    bool idle() {
+        try {
+            return d_wawt->idle(&d_screen);
+        }
+        catch (Wawt::Exception caught) {
+            throw Wawt::Exception("Idle on screen '" + d_name + "', "
+                                                            + caught.what());
+        }
+    }
+
     /**
      * @brief Refresh font assignments and text metrics.
      *
@@ -253,10 +344,12 @@ class WawtScreen {
      * It may also require updating the dimensions of the text so that
      * the associated alignment is correctly implemented.
      * This method is usually called after handling mouse events
-     * as this often triggers text changes.
+     * as this often triggers text changes.  Only widgets whose text or
+     * enablement was set since the last refresh are visited (see:
+     * 'Wawt::refreshChangedTextMetrics').
      */
     void refresh() {
-        d_wawt->refreshTextMetrics(&d_screen);
+        d_wawt->refreshChangedTextMetrics(&d_screen);
     }
 
     /**
@@ -265,13 +358,76 @@ class WawtScreen {
      * @param newWidth  The new width value (optionally the current width).
      * @param newHeight The new height value (optionally the current height).
      *
-     * This method should also be called if the mapping of 'TextId' values
-     * to strings change (e.g. a language change).
+     * The screen's 'TextId' values are mapped to strings again if the
+     * mapping was replaced since the last resize (see:
+     * 'WawtConnector::setTextMapper').  A mapper whose strings change
+     * without being replaced (e.g. on a language change) is not called
+     * again, as each string it returned is kept.
      */
     void resize(int newWidth = 0, int newHeight = 0) {
-        d_wawt->resizeRootPanel(&d_screen,
-                                double(newWidth  ? newWidth  : width()),
-                                double(newHeight ? newHeight : height()));
+        auto w      = newWidth  ? newWidth  : width();
+        auto h      = newHeight ? newHeight : height();
+        auto mapped = d_wawt->textMapperGeneration();
+
+        if (d_textGeneration != mapped) { // remembered layouts are stale
+            d_layoutCache.clear();
+            d_textGeneration = mapped;
+        }
+
+        if (d_layoutCacheLimit > 0 && restoreCachedLayout(w, h)) {
+            return;                                                   // RETURN
+        }
+
+        if (d_compiled.empty()) {
+            d_wawt->resizeRootPanel(&d_screen, double(w), double(h));
+        }
+        else {
+            d_wawt->resizeRootPanel(&d_compiled, double(w), double(h));
+        }
+
+        if (d_layoutCacheLimit > 0) {
+            saveCachedLayout(w, h);
+        }
+    }
+
+    /**
+     * @brief Remember the layout computed for each window size.
+     *
+     * @param maxBytes Memory limit for the remembered layouts ('0' disables
+     * the cache and discards its contents).
+     *
+     * When enabled, 'resize' records the positions, character sizes, and
+     * text metrics computed for the screen at each size, and restores them
+     * (without any text measurement) when that size is revisited.  The
+     * least recently used layouts are discarded to stay within 'maxBytes'.
+     * A remembered layout is discarded once the screen's text, list
+     * scroll positions, visibility, or widgets (e.g. a pop-up) change.
+     */
+    void setLayoutCacheLimit(std::size_t maxBytes) {
+        d_layoutCacheLimit = maxBytes;
+
+        if (maxBytes == 0) {
+            d_layoutCache.clear();
+        }
+    }
+
+    /**
+     * @brief Select whether the screen is processed in its compiled form.
+     *
+     * @param enable 'true' to draw, resize, and hit-test using a compiled
+     * copy of the screen's widget tree (see: 'Wawt::FlatScreen').
+     *
+     * Screens with many widgets are processed faster in their compiled
+     * form.  The results are the same either way.  This method requires
+     * 'setup' to have been performed.
+     */
+    void useCompiledScreen(bool enable) {
+        if (enable) {
+            Wawt::compileScreen(&d_compiled, &d_screen);
+        }
+        else {
+            d_compiled.clear();
+        }
     }
 
     /**
@@ -288,6 +444,11 @@ class WawtScreen {
     }
 
     // PUBLIC ACCESSSOR
+    //! Access the number of layouts remembered by 'resize'.
+    std::size_t cachedLayouts() const {
+        return d_layoutCache.size();
+    }
+
     //! Access the screen's height (requires 'setup' to have been performed).
     int height() const {
         return int(std::round(d_screen.adapterView().height()));
@@ -530,9 +691,7 @@ WawtScreenImpl<Derived,Option>::activate(const WawtScreen *current,
         reinterpret_cast<Derived*>(this)->resetWidgets(args...);
 
         if (current) {
-            d_wawt->resizeRootPanel(&d_screen,
-                                    double(current->width()),
-                                    double(current->height()));
+            resize(current->width(), current->height());
         }
     }
     catch (Wawt::Exception caught) {
@@ -565,9 +724,11 @@ WawtScreenImpl<Derived,Option>::setup(int        initialWidth,
 
     try {
         d_wawt->resolveWidgetIds(&d_screen);
-        d_wawt->resizeRootPanel(&d_screen,
-                                double(initialWidth),
-                                double(initialHeight));
+
+        if (!d_compiled.empty()) {
+            Wawt::compileScreen(&d_compiled, &d_screen);
+        }
+        resize(initialWidth, initialHeight);
     }
     catch (Wawt::Exception caught) {
         throw Wawt::Exception("Setup screen '" + d_name + "', "
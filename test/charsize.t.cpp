@@ -0,0 +1,163 @@
+/** @file charsize.t.cpp
+ *  @brief Test that 'searchCharSize' finds the size a binary search does.
+ *
+ * Copyright 2018 Bruce Szablak
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "charsizesearch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace BDS;
+
+namespace {
+
+int s_failures = 0;
+
+void check(bool passed, int line, const char *what)
+{
+    if (!passed) {
+        std::cerr << "charsize.t.cpp:" << line << ": " << what << std::endl;
+        s_failures += 1;
+    }
+}
+
+#define CHECK(expr) check((expr), __LINE__, #expr)
+
+using FitsFn = std::function<bool(unsigned int)>;
+
+// The search 'SfmlAdapter::getTextMetrics' made before sizes were
+// estimated: a binary search of all of the sizes up to 'upperLimit'.
+unsigned int binarySearch(unsigned int upperLimit, const FitsFn& fits)
+{
+    auto lowerLimit = 1u;
+    auto charSize   = upperLimit;
+
+    while (upperLimit - lowerLimit > 1) {
+        if (!fits(charSize)) {
+            upperLimit = charSize;
+        }
+        else {
+            lowerLimit = charSize;
+        }
+        charSize   = (upperLimit + lowerLimit)/2;
+    }
+    return lowerLimit;                                                // RETURN
+}
+
+// The advance of each character at size 100, like a proportional font's.
+double advance(wchar_t character)
+{
+    switch (character) {
+        case L'i': case L'l': case L'.': case L',': case L' ': return 28.0;
+        case L'm': case L'w': case L'M': case L'W':            return 83.0;
+        default: return character >= L'A' && character <= L'Z' ? 67.0 : 55.0;
+    }
+}
+
+const std::wstring s_corpus[] = {
+    L"",
+    L"i",
+    L"OK",
+    L"Cancel",
+    L"Hello, World!",
+    L"WWWWWWWWWWWW",
+    L"illicit lilies",
+    L"The quick brown fox jumps over the lazy dog.",
+    L"Multiple Widget Text Entry, Label and Button Sizes"
+};
+
+}  // unnamed namespace
+
+int main()
+{
+    std::mt19937 random(2018);
+
+    // Texts measured as in a hinted font: a text's width at a size is its
+    // width scaled from size 100, rounded, and sometimes a pixel wider.
+    // Hinting is not monotone, but a box the text fits in at a size must
+    // fit it at the smaller ones, so only the first size not fitting is
+    // used.  The estimate is the one 'SfmlAdapter' makes from the scaled
+    // widths, which may be off by a size or so.
+    for (auto& text : s_corpus) {
+        auto width = 0.0;
+
+        for (auto character : text) {
+            width += advance(character);
+        }
+
+        for (auto trial = 0; trial < 2000; ++trial) {
+            auto boxWidth   = 1.0 + double(random() % 2000);
+            auto boxHeight  = 1.0 + double(random() % 300);
+            auto upperLimit = 1u + unsigned(random() % 300);
+            auto hinting    = random();
+            auto raw        = [&](unsigned int size) {
+                auto wider  = (hinting >> (size % 32)) & 1;
+                auto scaled = std::round(width * size / 100.0) + wider;
+
+                return 1.2 * size < boxHeight && scaled < boxWidth;
+            };
+            auto first      = 1u;
+
+            while (first <= upperLimit && raw(first)) {
+                first += 1;
+            }
+            auto calls      = 0;
+            auto fits       = [&](unsigned int size) {
+                calls += 1;
+                return size < first;
+            };
+            auto scale      = boxHeight / 1.2;
+
+            if (width > 0) {
+                scale = std::min(scale, boxWidth * 100.0 / width);
+            }
+            auto estimate   = unsigned(std::max(2.0,
+                                                std::min(std::ceil(scale) - 1,
+                                                         double(upperLimit))));
+            auto expected   = binarySearch(upperLimit, fits);
+
+            calls = 0;
+            CHECK(searchCharSize(estimate, upperLimit, fits) == expected);
+
+            if (upperLimit > 2 && estimate == expected
+                               && expected < upperLimit) {
+                CHECK(calls == 2); // the estimate, and the size above it
+            }
+        }
+    }
+
+    // Any monotone predicate, and any estimate (even one out of range):
+    for (auto trial = 0; trial < 100000; ++trial) {
+        auto upperLimit = 1u + unsigned(random() % 400);
+        auto threshold  = unsigned(random() % 420);
+        auto estimate   = unsigned(random() % 430);
+        auto fits       = [threshold](unsigned int size) {
+            return size <= threshold;
+        };
+
+        CHECK(searchCharSize(estimate, upperLimit, fits)
+                                        == binarySearch(upperLimit, fits));
+    }
+
+    return s_failures == 0 ? 0 : 1;                                   // RETURN
+}
+
+// vim: ts=4:sw=4:et:ai
@@ -0,0 +1,120 @@
+/** @file listrows.t.cpp
+ *  @brief Test of the text metrics of rows added to a resolved 'List'.
+ *
+ * Copyright 2018 Bruce Szablak
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wawt.h"
+
+#include <iostream>
+#include <string>
+
+using namespace BDS;
+
+namespace {
+
+int s_failures = 0;
+
+void check(bool passed, int line, const char *what)
+{
+    if (!passed) {
+        std::cerr << "listrows.t.cpp:" << line << ": " << what << std::endl;
+        s_failures += 1;
+    }
+}
+
+#define CHECK(expr) check((expr), __LINE__, #expr)
+
+// Measures each character as half as wide as it is high.
+class Measure : public Wawt::DrawAdapter {
+  public:
+    void  draw(const Wawt::DrawDirective&, const std::wstring&) override {
+    }
+
+    void  getTextMetrics(Wawt::DrawDirective   *parameters,
+                         Wawt::TextMetrics     *metrics,
+                         const std::wstring&   text,
+                         double                upperLimit) override {
+        if (upperLimit > 0) {
+            auto size = metrics->d_textHeight - 1;
+
+            if (!text.empty() && size*text.length()/2 > metrics->d_textWidth) {
+                size = 2*metrics->d_textWidth/text.length();
+            }
+            parameters->d_charSize = unsigned(size);
+        }
+        metrics->d_textWidth  = parameters->d_charSize*text.length()/2;
+        metrics->d_textHeight = parameters->d_charSize;
+    }
+};
+
+double width(const Wawt::Button& button)
+{
+    return button.textView().metrics().d_textWidth;
+}
+
+}  // unnamed namespace
+
+int main()
+{
+    Measure      adapter;
+    Wawt         wawt(&adapter);
+    Wawt::Vertex upperLeft(-1.0_M, -1.0_M);
+    Wawt::Vertex lowerRight(1.0_M, 1.0_M);
+    Wawt::Panel  screen(Wawt::Layout(Wawt::Position(),
+                                     Wawt::Position(upperLeft, 599, 399)), {
+        Wawt::List(Wawt::Layout(Wawt::Position(upperLeft),
+                                Wawt::Position(lowerRight)),
+                   1_F,
+                   Wawt::ListType::eVIEWLIST,
+                   6u)
+    });
+    wawt.resolveWidgetIds(&screen);
+    wawt.resizeRootPanel(&screen, 600, 400);
+
+    auto& list = screen.lookup<Wawt::List>(1_w, "list");
+
+    list.append().textView().setText(std::wstring(L"one"));
+    list.append().textView().setText(std::wstring(L"two"));
+    wawt.refreshChangedTextMetrics(&screen);
+
+    auto charSize = list.row(0).adapterView().d_charSize;
+
+    CHECK(charSize > 0);
+    CHECK(width(list.row(0)) == charSize*3/2);
+    CHECK(width(list.row(1)) == charSize*3/2);
+
+    // Growing the list past its capacity copies the existing rows, which
+    // keep their text metrics:
+    list.row(3).textView().setText(std::wstring(L"four"));
+    list.row(2).textView().setText(std::wstring(L"three"));
+    wawt.refreshChangedTextMetrics(&screen);
+
+    CHECK(list.rows().size() == 4);
+    CHECK(list.row(3).adapterView().d_charSize == charSize);
+    CHECK(width(list.row(3)) == charSize*4/2);
+    CHECK(width(list.row(2)) == charSize*5/2);
+    CHECK(width(list.row(0)) == charSize*3/2);
+
+    // A row that is added but not set is measured as well:
+    list.row(4);
+    wawt.refreshChangedTextMetrics(&screen);
+
+    CHECK(list.row(4).adapterView().d_charSize == charSize);
+
+    return s_failures == 0 ? 0 : 1;                                   // RETURN
+}
+
+// vim: ts=4:sw=4:et:ai
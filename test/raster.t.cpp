@@ -0,0 +1,136 @@
+/** @file raster.t.cpp
+ *  @brief Golden pixel test of the 'RasterAdapter'.
+ *
+ * Copyright 2018 Bruce Szablak
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rasteradapter.h"
+#include "wawt.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+using namespace BDS;
+
+namespace {
+
+int s_failures = 0;
+
+void check(bool passed, int line, const char *what)
+{
+    if (!passed) {
+        std::cerr << "raster.t.cpp:" << line << ": " << what << std::endl;
+        s_failures += 1;
+    }
+}
+
+#define CHECK(expr) check((expr), __LINE__, #expr)
+
+// The frame digest recorded when the screen below was first drawn.  A
+// change to how any widget is rasterized changes it: check the new frame
+// (e.g. write it out as a PPM file) before updating it.
+constexpr uint64_t kGOLDEN = 0x91505f18c3d0036bull;
+
+uint64_t digest(const RasterAdapter& adapter)
+{
+    auto value = uint64_t(14695981039346656037ull); // FNV-1a
+
+    for (auto pixel : adapter.pixels()) {
+        for (auto i = 0; i < 4; ++i) {
+            value ^= (pixel >> (8*i)) & 0xff;
+            value *= 1099511628211ull;
+        }
+    }
+    return value;                                                     // RETURN
+}
+
+Wawt::Layout box(double ulx, double uly, double lrx, double lry)
+{
+    return Wawt::Layout(Wawt::Position(Wawt::Vertex(Wawt::Metric(ulx),
+                                                    Wawt::Metric(uly))),
+                        Wawt::Position(Wawt::Vertex(Wawt::Metric(lrx),
+                                                    Wawt::Metric(lry))));
+}
+
+}  // unnamed namespace
+
+int main()
+{
+    RasterAdapter adapter(160, 120);
+    Wawt          wawt(&adapter);
+    Wawt::Vertex  upperLeft(-1.0_M, -1.0_M);
+
+    wawt.setWidgetOptionDefaults(DrawOptions::defaults());
+
+    Wawt::Panel   screen(Wawt::Layout(Wawt::Position(),
+                                      Wawt::Position(upperLeft, 159, 119)), {
+        Wawt::Label(box(-1.0, -1.0, 1.0, -0.7),
+                    Wawt::TextString(L"Golden", 1_F)),
+        Wawt::Button(box(-0.9, -0.6, -0.1, -0.2),
+                     Wawt::InputHandler(Wawt::OnClickCb()),
+                     Wawt::TextString(L"Press")),
+        Wawt::List(box(0.1, -0.6, 0.9, 0.3),
+                   2_F,
+                   Wawt::ListType::eRADIOLIST,
+                   {Wawt::List::Label(Wawt::TextString(L"one")),
+                    Wawt::List::Label(Wawt::TextString(L"two"), true)}),
+        Wawt::TextEntry(box(-0.9, 0.5, 0.9, 0.9),
+                        8u,
+                        Wawt::TextString(L"entry"))
+    });
+    wawt.resolveWidgetIds(&screen);
+    wawt.resizeRootPanel(&screen, 160, 120);
+    adapter.clear();
+    wawt.draw(screen);
+
+    auto golden = digest(adapter);
+    auto screenColor
+        = RasterAdapter::makePixel(DrawOptions::Color(160u, 160u, 255u, 255u));
+
+    CHECK(adapter.pixel(0, 0)     == screenColor);
+    CHECK(adapter.pixel(159, 119) == screenColor);
+
+    if (golden != kGOLDEN) {
+        std::cerr << "raster.t.cpp: frame digest " << std::hex << golden
+                  << std::endl;
+        s_failures += 1;
+    }
+
+    // Bold glyphs are smeared a unit into the space after them, so bold
+    // text is measured a unit (2 pixels at size 16) wider:
+    Wawt::DrawDirective plain{std::any(DrawOptions())};
+    Wawt::DrawDirective bold{std::any(DrawOptions().bold())};
+    Wawt::TextMetrics   plainMetrics{100, 100}; // the box to fit in
+    Wawt::TextMetrics   boldMetrics{100, 100};
+
+    plain.d_charSize = bold.d_charSize = 16;
+    adapter.getTextMetrics(&plain, &plainMetrics, L"abc", 0);
+    adapter.getTextMetrics(&bold,  &boldMetrics,  L"abc", 0);
+
+    CHECK(plainMetrics.d_textWidth == 34);
+    CHECK(boldMetrics.d_textWidth  == 36);
+
+    // Drawn in tiles on several threads, the pixels are the same:
+    adapter.setThreads(4);
+    adapter.clear();
+    wawt.draw(screen);
+
+    CHECK(digest(adapter) == golden);
+
+    return s_failures == 0 ? 0 : 1;                                   // RETURN
+}
+
+// vim: ts=4:sw=4:et:ai
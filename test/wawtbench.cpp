@@ -0,0 +1,460 @@
+/** @file wawtbench.cpp
+ *  @brief Timings of the layout, lookup and draw paths of 'Wawt'.
+ *
+ * Copyright 2018 Bruce Szablak
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Usage: wawtbench [section...]
+//
+// Runs each section named (all of them by default) on synthetic screens of
+// about 1k and 10k widgets, and prints the time per call.  The faster path
+// is always compared with the path it replaced, run in the same process:
+// only those ratios mean anything, as the absolute times depend on the
+// build (the top level 'CMakeLists.txt' builds 'Debug' by default).  An
+// adapter needing a display (i.e. 'SfmlAdapter') is not timed; "batch"
+// counts the calls it would make.  This is not a test, so it is not run
+// by 'ctest'.
+
+#include "rasteradapter.h"
+#include "wawt.h"
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace BDS;
+
+namespace {
+
+// Measures each character as half as wide as it is high.
+class Measure : public Wawt::DrawAdapter {
+  public:
+    std::size_t d_draws = 0;
+
+    void  draw(const Wawt::DrawDirective&, const std::wstring&) override {
+        d_draws += 1;
+    }
+
+    void  getTextMetrics(Wawt::DrawDirective   *parameters,
+                         Wawt::TextMetrics     *metrics,
+                         const std::wstring&   text,
+                         double                upperLimit) override {
+        if (upperLimit > 0) {
+            auto size = metrics->d_textHeight - 1;
+
+            if (!text.empty() && size*text.length()/2 > metrics->d_textWidth) {
+                size = 2*metrics->d_textWidth/text.length();
+            }
+            parameters->d_charSize = unsigned(size);
+        }
+        metrics->d_textWidth  = parameters->d_charSize*text.length()/2;
+        metrics->d_textHeight = parameters->d_charSize;
+    }
+};
+
+// Keeps its frames, and counts the pixels in the damage it is given.
+class Retain : public Measure {
+  public:
+    double d_damaged = 0.0;
+
+    bool  retainsFrame() const override {
+        return true;
+    }
+
+    bool  damage(const std::vector<Wawt::DrawRegion>& regions,
+                 bool                                 wholeFrame) override {
+        for (auto& region : regions) {
+            d_damaged += (region.d_lowerRight.d_x-region.d_upperLeft.d_x+1)
+                       * (region.d_lowerRight.d_y-region.d_upperLeft.d_y+1);
+        }
+        return !wholeFrame;
+    }
+};
+
+// Takes the directives in batches, and counts them.
+class Batching : public Measure {
+  public:
+    std::size_t d_batches = 0;
+    std::size_t d_texts   = 0;
+
+    void  drawBatch(const Wawt::DrawBatch& batch) override {
+        d_batches += 1;
+
+        for (auto text : batch.d_texts) {
+            d_texts += text && !text->empty() ? 1 : 0;
+        }
+    }
+
+    bool  drawsBatches() const override {
+        return true;
+    }
+};
+
+// Return the microseconds per call of 'body', run for at least 'minimum'
+// seconds (and at least once).
+double microseconds(const std::function<void()>& body, double minimum = 0.25)
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto calls = 0;
+    auto start = Clock::now();
+    auto spent = std::chrono::duration<double>(0);
+
+    do {
+        body();
+        calls += 1;
+        spent  = Clock::now() - start;
+    } while (spent.count() < minimum);
+
+    return 1.0e6*spent.count()/calls;                                 // RETURN
+}
+
+// The layout of the 'k'th of ten children laid out side by side
+// ('across') or one above the other.  All but the first child are placed
+// against the previous one, so the layout has dependencies to follow.
+Wawt::Layout slot(int k, bool across)
+{
+    auto edge  = Wawt::Metric(-1.0 + 0.2*(k+1));
+    auto lower = across ? Wawt::Vertex(edge, 1.0_M)
+                        : Wawt::Vertex(1.0_M, edge);
+
+    if (k == 0) {
+        return Wawt::Layout(Wawt::Position(), Wawt::Position(lower)); // RETURN
+    }
+    auto upper = across ? Wawt::Vertex(1.0_M, -1.0_M)
+                        : Wawt::Vertex(-1.0_M, 1.0_M);
+    auto prior = Wawt::WidgetId(uint16_t(k), true, true);
+
+    return Wawt::Layout(Wawt::Position(upper, prior),
+                        Wawt::Position(lower));                       // RETURN
+}
+
+Wawt::FocusCb ignore(bool, int, int, Wawt::Base*)
+{
+    return Wawt::FocusCb();                                           // RETURN
+}
+
+Wawt::Panel::Widget button(int k)
+{
+    return Wawt::Button(slot(k, true),
+                        Wawt::InputHandler(&ignore),
+                        Wawt::TextString(L"b" + std::to_wstring(k)));
+}
+
+Wawt::Panel::Widget place(Wawt::Panel part, int k, bool across)
+{
+    part.layoutView() = slot(k, across);
+    return part;                                                      // RETURN
+}
+
+// Return a panel of ten copies of 'part' (which is 1/10th of its size).
+Wawt::Panel tenOf(const Wawt::Panel& part, bool across)
+{
+    return Wawt::Panel(Wawt::Layout(), {
+        place(part, 0, across), place(part, 1, across),
+        place(part, 2, across), place(part, 3, across),
+        place(part, 4, across), place(part, 5, across),
+        place(part, 6, across), place(part, 7, across),
+        place(part, 8, across), place(part, 9, across)
+    });
+}
+
+// Return a root panel of 10^'levels' buttons in nested panels, e.g. 1111
+// widgets for 3 levels, and 11111 for 4.
+Wawt::Panel screen(int levels)
+{
+    auto part   = Wawt::Panel(Wawt::Layout(), {
+        button(0), button(1), button(2), button(3), button(4),
+        button(5), button(6), button(7), button(8), button(9)
+    });
+    auto across = false;
+
+    while (--levels > 1) {
+        part    = tenOf(part, across);
+        across  = !across;
+    }
+    auto root   = tenOf(part, across);
+
+    root.layoutView()
+        = Wawt::Layout(Wawt::Position(),
+                       Wawt::Position(Wawt::Vertex(-1.0_M, -1.0_M),
+                                      1279, 799));
+    return root;                                                      // RETURN
+}
+
+struct Screens {
+    int         d_levels;
+    std::size_t d_widgets;
+    Wawt::Panel d_resolved; // has an index, so is compiled
+    Wawt::Panel d_copy;     // same tree without one, so is interpreted
+
+    Screens(Wawt *wawt, int levels)
+        : d_levels(levels)
+        , d_widgets(0)
+        , d_resolved(screen(levels)) {
+        wawt->resolveWidgetIds(&d_resolved);
+        wawt->resizeRootPanel(&d_resolved, 1280, 800);
+        d_copy    = d_resolved;
+        d_widgets = std::size_t(d_resolved.d_widgetId.value());
+    }
+};
+
+void report(const char  *section,
+            std::size_t  widgets,
+            const char  *fast,
+            double       fastTime,
+            const char  *slow,
+            double       slowTime)
+{
+    std::cout << std::left  << std::setw(8)  << section
+              << std::right << std::setw(6)  << widgets << " widgets  "
+              << std::left  << std::setw(12) << fast
+              << std::right << std::setw(10) << std::fixed
+                                             << std::setprecision(1)
+                                             << fastTime << " us  "
+              << std::left  << std::setw(12) << slow
+              << std::right << std::setw(10) << slowTime << " us  x"
+              << std::setprecision(2) << slowTime/fastTime << std::endl;
+}
+
+void layout(Wawt *wawt, Screens *screens)
+{
+    // Interpret the layout on each resize, alternating the size so every
+    // call does the work.
+    auto policy = wawt->resizePolicy();
+    auto wide   = false;
+    auto resize = [wawt, &wide](Wawt::Panel *root) {
+        return [wawt, &wide, root]() {
+            wide = !wide;
+            wawt->resizeRootPanel(root, wide ? 1280 : 1024, 800);
+        };
+    };
+
+    wawt->setResizePolicy({Wawt::ResizePolicy::Mode::eINTERPRET});
+    report("layout",
+           screens->d_widgets,
+           "compiled",
+           microseconds(resize(&screens->d_resolved)),
+           "interpreted",
+           microseconds(resize(&screens->d_copy)));
+    wawt->setResizePolicy(policy);
+
+    // Find the view of every widget but the root.
+    auto findAll = [screens](const Wawt::Panel *root) {
+        return [screens, root]() {
+            for (auto id = 1u; id < screens->d_widgets; ++id) {
+                auto widgetId = Wawt::WidgetId(uint16_t(id), true, false);
+
+                if (!root->findView(widgetId)) {
+                    throw Wawt::Exception("Widget not found.");       // THROW
+                }
+            }
+        };
+    };
+    report("lookup",
+           screens->d_widgets,
+           "indexed",
+           microseconds(findAll(&screens->d_resolved)),
+           "tree walk",
+           microseconds(findAll(&screens->d_copy)));
+}
+
+void draw(Wawt *wawt, Screens *screens)
+{
+    // The adapter draws nothing, so this is the cost of 'Wawt::draw'.
+    auto drawAll = [wawt](const Wawt::Panel *root) {
+        return [wawt, root]() {
+            wawt->draw(*root);
+        };
+    };
+    report("draw",
+           screens->d_widgets,
+           "replayed",
+           microseconds(drawAll(&screens->d_resolved)),
+           "tree walk",
+           microseconds(drawAll(&screens->d_copy)));
+}
+
+void damage(Wawt *wawt, Screens *screens)
+{
+    // Press and release the button at the center of the screen, drawing
+    // after each.  A retained frame is only redrawn where it changed.
+    auto& root    = screens->d_resolved;
+    auto  clickOn = [&root](Wawt *drawer) {
+        return [&root, drawer]() {
+            auto x  = int(root.adapterView().width()/2);
+            auto y  = int(root.adapterView().height()/2);
+            auto up = root.downEvent(x, y);
+
+            drawer->draw(root);
+            up(x, y, true);
+            drawer->draw(root);
+        };
+    };
+    Retain adapter;
+    Wawt   retained(&adapter);
+
+    retained.draw(root); // the first frame is whole
+    retained.resetDrawCounters();
+    adapter.d_damaged = 0.0;
+
+    auto partialTime = microseconds(clickOn(&retained));
+    auto counters    = retained.drawCounters();
+
+    wawt->draw(root);
+    wawt->resetDrawCounters();
+    wawt->draw(root);
+
+    auto drawn       = wawt->drawCounters().d_drawn;
+    auto pixels      = root.adapterView().width()
+                     * root.adapterView().height();
+
+    report("damage",
+           screens->d_widgets,
+           "partial",
+           partialTime,
+           "whole frame",
+           microseconds(clickOn(wawt)));
+    std::cout << "        per frame: "
+              << std::setprecision(0) << adapter.d_damaged/counters.d_frames
+              << " of " << pixels << " pixels and "
+              << std::setprecision(1)
+              << double(counters.d_drawn)/counters.d_frames
+              << " of " << drawn << " commands drawn" << std::endl;
+}
+
+void batch(Wawt *, Screens *screens)
+{
+    // An adapter drawing batches (e.g. 'SfmlAdapter') makes one call for
+    // the geometry of each, but one per text still.  The time of such an
+    // adapter's draw calls needs a window, so only Wawt's time is taken.
+    auto&    root = screens->d_resolved;
+    Batching batching;
+    Measure  single;
+    Wawt     batched(&batching);
+    Wawt     unbatched(&single);
+
+    batched.draw(root);
+    unbatched.draw(root);
+    batched.resetDrawCounters();
+    unbatched.resetDrawCounters();
+    batching.d_batches = batching.d_texts = single.d_draws = 0;
+
+    report("batch",
+           screens->d_widgets,
+           "batched",
+           microseconds([&batched, &root]() {
+                            batched.draw(root);
+                        }),
+           "per widget",
+           microseconds([&unbatched, &root]() {
+                            unbatched.draw(root);
+                        }));
+
+    auto frames = double(batched.drawCounters().d_frames);
+
+    std::cout << "        per frame: "
+              << std::setprecision(1) << batching.d_batches/frames
+              << " batches and " << batching.d_texts/frames
+              << " texts instead of "
+              << single.d_draws/double(unbatched.drawCounters().d_frames)
+              << " draw calls" << std::endl;
+}
+
+void raster(Wawt *, Screens *screens)
+{
+    // Draw a full HD frame in software, in tiles on each number of
+    // threads; the pixels must not depend on it.
+    RasterAdapter adapter(1920, 1080);
+    Wawt          wawt(&adapter);
+
+    wawt.setWidgetOptionDefaults(DrawOptions::defaults());
+
+    Screens frame(&wawt, screens->d_levels);
+    auto    serial = std::vector<RasterAdapter::Pixel>();
+    auto    time   = 0.0;
+
+    wawt.resizeRootPanel(&frame.d_resolved, 1920, 1080);
+    adapter.clear(); // the root panel paints every pixel after this
+
+    for (auto threads : {1u, 2u, 4u, 8u}) {
+        adapter.setThreads(threads);
+
+        auto spent = microseconds([&wawt, &frame]() {
+                                      wawt.draw(frame.d_resolved);
+                                  });
+
+        if (threads == 1) {
+            serial = adapter.pixels();
+            time   = spent;
+            continue;                                             // CONTINUE
+        }
+
+        if (adapter.pixels() != serial) {
+            throw Wawt::Exception("Tiled frame differs.");            // THROW
+        }
+        auto name = std::to_string(threads) + " threads";
+
+        report("raster",
+               frame.d_widgets,
+               name.c_str(),
+               spent,
+               "serial",
+               time);
+    }
+}
+
+struct Section {
+    const char *d_name;
+    void      (*d_run)(Wawt *, Screens *);
+};
+
+const Section s_sections[] = {
+    { "layout", &layout },
+    { "draw",   &draw   },
+    { "damage", &damage },
+    { "batch",  &batch  },
+    { "raster", &raster }
+};
+
+}  // unnamed namespace
+
+int main(int argc, char **argv)
+{
+    Measure adapter;
+    Wawt    wawt(&adapter);
+    Screens small(&wawt, 3);
+    Screens large(&wawt, 4);
+
+    for (auto& section : s_sections) {
+        auto run = argc == 1;
+
+        for (auto i = 1; i < argc; ++i) {
+            run = run || std::strcmp(argv[i], section.d_name) == 0;
+        }
+
+        if (run) {
+            section.d_run(&wawt, &small);
+            section.d_run(&wawt, &large);
+        }
+    }
+    return 0;                                                         // RETURN
+}
+
+// vim: ts=4:sw=4:et:ai